@@ -0,0 +1,192 @@
+#include <fcntl.h>
+#include <raylib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ASSET_BUNDLE_MAGIC 0x4C444E42 // "BNDL"
+#define ASSET_BUNDLE_VERSION 1
+
+// Payloads start on page boundaries so instances mapping the same bundle
+// share the page cache, and identical payloads share the same pages
+#define ASSET_BUNDLE_ALIGNMENT 4096
+
+#define ASSET_NAME_LENGTH 96
+
+// Largest image side a bundle entry may claim, keeps pixel sizes in an int
+#define ASSET_MAX_IMAGE_SIZE 8192
+
+enum
+{
+  ASSET_TYPE_WAVE = 1,
+  ASSET_TYPE_IMAGE = 2,
+};
+
+// On-disk header, followed directly by entryCount entries
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+} AssetBundleHeader;
+
+// On-disk index entry, payload lives at [offset, offset + size)
+typedef struct AssetBundleEntry
+{
+  char name[ASSET_NAME_LENGTH];
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+  uint64_t hash;
+
+  // Wave: frameCount, sampleRate, sampleSize, channels
+  // Image: width, height, format, mipmaps
+  uint32_t params[4];
+} AssetBundleEntry;
+
+uint64_t hashAssetData(const void *data, size_t size)
+{
+  // FNV-1a
+  const unsigned char *bytes = data;
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+AssetBundle *openAssetBundle(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat info;
+  if (fstat(fd, &info) < 0 || info.st_size < (off_t)sizeof(AssetBundleHeader))
+  {
+    close(fd);
+    return NULL;
+  }
+
+  // Read-only shared mapping, the payloads are handed to raylib as-is
+  void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return NULL;
+
+  AssetBundleHeader *header = data;
+  size_t indexEnd = sizeof(AssetBundleHeader) +
+                    (size_t)header->entryCount * sizeof(AssetBundleEntry);
+
+  if (header->magic != ASSET_BUNDLE_MAGIC ||
+      header->version != ASSET_BUNDLE_VERSION ||
+      indexEnd > (size_t)info.st_size)
+  {
+    printf("WARNING: Ignoring invalid asset bundle %s\n", path);
+    munmap(data, info.st_size);
+    return NULL;
+  }
+
+  AssetBundle *bundle = trackedMalloc(MEMORY_ASSETS, sizeof(AssetBundle));
+  bundle->data = data;
+  bundle->size = info.st_size;
+  bundle->entryCount = header->entryCount;
+  bundle->entries =
+      (AssetBundleEntry *)((char *)data + sizeof(AssetBundleHeader));
+
+  return bundle;
+}
+
+void closeAssetBundle(AssetBundle *bundle)
+{
+  if (bundle == NULL)
+    return;
+
+  munmap(bundle->data, bundle->size);
+  trackedFree(bundle);
+}
+
+AssetBundleEntry *findAssetBundleEntry(AssetBundle *bundle, const char *name,
+                                       uint32_t type)
+{
+  if (bundle == NULL)
+    return NULL;
+
+  for (int i = 0; i < bundle->entryCount; i++)
+  {
+    AssetBundleEntry *entry = &bundle->entries[i];
+
+    if (entry->type == type && strncmp(entry->name, name, ASSET_NAME_LENGTH) == 0)
+    {
+      // Written so a huge offset or size can't wrap around
+      if (entry->offset > bundle->size ||
+          entry->size > bundle->size - entry->offset)
+        return NULL;
+
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+// The returned Wave points into the mapping, it must not be unloaded
+bool getBundleWave(AssetBundle *bundle, const char *name, Wave *wave)
+{
+  AssetBundleEntry *entry = findAssetBundleEntry(bundle, name, ASSET_TYPE_WAVE);
+  if (entry == NULL)
+    return false;
+
+  // A stale or damaged entry whose samples don't fill its payload exactly
+  // would be read past, fall back to the loose file instead
+  uint64_t bytes =
+      (uint64_t)entry->params[0] * entry->params[3] * (entry->params[2] / 8);
+  if (bytes == 0 || bytes != entry->size)
+    return false;
+
+  wave->frameCount = entry->params[0];
+  wave->sampleRate = entry->params[1];
+  wave->sampleSize = entry->params[2];
+  wave->channels = entry->params[3];
+  wave->data = (char *)bundle->data + entry->offset;
+
+  return true;
+}
+
+// The returned Image points into the mapping, it must not be unloaded
+bool getBundleImage(AssetBundle *bundle, const char *name, Image *image)
+{
+  AssetBundleEntry *entry =
+      findAssetBundleEntry(bundle, name, ASSET_TYPE_IMAGE);
+  if (entry == NULL)
+    return false;
+
+  // Only single level images whose pixels fit in the payload
+  uint32_t width = entry->params[0], height = entry->params[1];
+  if (width == 0 || height == 0 || width > ASSET_MAX_IMAGE_SIZE ||
+      height > ASSET_MAX_IMAGE_SIZE || entry->params[3] != 1)
+    return false;
+
+  int bytes = GetPixelDataSize(width, height, entry->params[2]);
+  if (bytes <= 0 || (uint64_t)bytes > entry->size)
+    return false;
+
+  image->width = entry->params[0];
+  image->height = entry->params[1];
+  image->format = entry->params[2];
+  image->mipmaps = entry->params[3];
+  image->data = (char *)bundle->data + entry->offset;
+
+  return true;
+}
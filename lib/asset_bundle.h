@@ -0,0 +1,14 @@
+#include "asset_bundle.c"
+
+uint64_t hashAssetData(const void *data, size_t size);
+
+AssetBundle *openAssetBundle(const char *path);
+
+void closeAssetBundle(AssetBundle *bundle);
+
+AssetBundleEntry *findAssetBundleEntry(AssetBundle *bundle, const char *name,
+                                       uint32_t type);
+
+bool getBundleWave(AssetBundle *bundle, const char *name, Wave *wave);
+
+bool getBundleImage(AssetBundle *bundle, const char *name, Image *image);
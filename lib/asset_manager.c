@@ -0,0 +1,238 @@
+#include <pthread.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void *decodeAssets(void *arg)
+{
+  AssetManager *manager = (AssetManager *)arg;
+
+  while (true)
+  {
+    pthread_mutex_lock(&manager->mutex);
+    while (manager->nextRequest >= manager->requestCount && !manager->stopping)
+    {
+      pthread_cond_wait(&manager->requestAdded, &manager->mutex);
+    }
+
+    if (manager->nextRequest >= manager->requestCount)
+    {
+      pthread_mutex_unlock(&manager->mutex);
+      return NULL;
+    }
+
+    AssetRequest *request = &manager->requests[manager->nextRequest++];
+    request->state = ASSET_DECODING;
+    pthread_mutex_unlock(&manager->mutex);
+
+    // Decoding only touches CPU memory, so it is safe off the main thread
+    bool decoded;
+    if (request->isImage)
+    {
+      request->fromBundle =
+          getBundleImage(manager->bundle, request->path, &request->image);
+      if (!request->fromBundle)
+        request->image = LoadImage(request->path);
+      decoded = request->image.data != NULL;
+    }
+    else
+    {
+      request->fromBundle =
+          getBundleWave(manager->bundle, request->path, &request->wave);
+      if (!request->fromBundle)
+        request->wave = LoadWave(request->path);
+      decoded = request->wave.data != NULL;
+    }
+
+    pthread_mutex_lock(&manager->mutex);
+    request->state = decoded ? ASSET_DECODED : ASSET_FAILED;
+    if (!decoded)
+    {
+      printf("WARNING: Failed to decode %s\n", request->path);
+      manager->finishedCount++;
+    }
+    pthread_mutex_unlock(&manager->mutex);
+  }
+}
+
+AssetManager *createAssetManager(int maxRequests, int numDecoderThreads,
+                                 const char *bundlePath)
+{
+  AssetManager *manager = trackedCalloc(MEMORY_ASSETS, 1, sizeof(AssetManager));
+
+  manager->maxRequests = maxRequests;
+  manager->requests =
+      trackedCalloc(MEMORY_ASSETS, maxRequests, sizeof(AssetRequest));
+  manager->bundle = openAssetBundle(bundlePath);
+
+  pthread_mutex_init(&manager->mutex, NULL);
+  pthread_cond_init(&manager->requestAdded, NULL);
+
+  manager->numDecoderThreads = numDecoderThreads;
+  manager->decoderThreads =
+      trackedCalloc(MEMORY_ASSETS, numDecoderThreads, sizeof(pthread_t));
+
+  for (int i = 0; i < numDecoderThreads; i++)
+  {
+    pthread_create(&manager->decoderThreads[i], NULL, decodeAssets,
+                   (void *)manager);
+  }
+
+  return manager;
+}
+
+void queueAsset(AssetManager *manager, const char *path, bool isImage)
+{
+  pthread_mutex_lock(&manager->mutex);
+
+  if (manager->requestCount < manager->maxRequests)
+  {
+    AssetRequest *request = &manager->requests[manager->requestCount];
+    snprintf(request->path, sizeof(request->path), "%s", path);
+    request->isImage = isImage;
+    request->state = ASSET_QUEUED;
+
+    manager->requestCount++;
+    pthread_cond_signal(&manager->requestAdded);
+  }
+  else
+  {
+    printf("WARNING: Asset queue full, %s will load synchronously\n", path);
+  }
+
+  pthread_mutex_unlock(&manager->mutex);
+}
+
+// Uploads decoded assets to the GPU / audio device until the time budget is
+// spent. Must be called from the main thread.
+void uploadDecodedAssets(AssetManager *manager, double budgetSeconds)
+{
+  double start = GetTime();
+
+  for (int i = 0; i < manager->requestCount; i++)
+  {
+    AssetRequest *request = &manager->requests[i];
+
+    pthread_mutex_lock(&manager->mutex);
+    bool ready = request->state == ASSET_DECODED;
+    pthread_mutex_unlock(&manager->mutex);
+
+    if (!ready)
+      continue;
+
+    if (request->isImage)
+    {
+      request->texture = LoadTextureFromImage(request->image);
+      if (!request->fromBundle)
+        UnloadImage(request->image);
+    }
+    else
+    {
+      request->sound = LoadSoundFromWave(request->wave);
+      if (!request->fromBundle)
+        UnloadWave(request->wave);
+    }
+
+    pthread_mutex_lock(&manager->mutex);
+    request->state = ASSET_UPLOADED;
+    manager->finishedCount++;
+    pthread_mutex_unlock(&manager->mutex);
+
+    if (GetTime() - start > budgetSeconds)
+      break;
+  }
+}
+
+float getAssetLoadingProgress(AssetManager *manager)
+{
+  pthread_mutex_lock(&manager->mutex);
+  float progress = manager->requestCount == 0
+                       ? 1
+                       : (float)manager->finishedCount / manager->requestCount;
+  pthread_mutex_unlock(&manager->mutex);
+
+  return progress;
+}
+
+bool areAssetsLoaded(AssetManager *manager)
+{
+  pthread_mutex_lock(&manager->mutex);
+  bool loaded = manager->finishedCount == manager->requestCount;
+  pthread_mutex_unlock(&manager->mutex);
+
+  return loaded;
+}
+
+AssetRequest *findUploadedAsset(AssetManager *manager, const char *path)
+{
+  if (manager == NULL)
+    return NULL;
+
+  for (int i = 0; i < manager->requestCount; i++)
+  {
+    if (manager->requests[i].state == ASSET_UPLOADED &&
+        strcmp(manager->requests[i].path, path) == 0)
+    {
+      return &manager->requests[i];
+    }
+  }
+
+  return NULL;
+}
+
+bool getLoadedSound(AssetManager *manager, const char *path, Sound *sound)
+{
+  AssetRequest *request = findUploadedAsset(manager, path);
+  if (request == NULL || request->isImage)
+    return false;
+
+  *sound = request->sound;
+  return true;
+}
+
+bool getLoadedTexture(AssetManager *manager, const char *path,
+                      Texture2D *texture)
+{
+  AssetRequest *request = findUploadedAsset(manager, path);
+  if (request == NULL || !request->isImage)
+    return false;
+
+  *texture = request->texture;
+  return true;
+}
+
+// Stops the decoders and releases the bundle. Uploaded sounds and textures
+// are owned by the game and stay loaded.
+void destroyAssetManager(AssetManager *manager)
+{
+  pthread_mutex_lock(&manager->mutex);
+  manager->stopping = true;
+  pthread_cond_broadcast(&manager->requestAdded);
+  pthread_mutex_unlock(&manager->mutex);
+
+  for (int i = 0; i < manager->numDecoderThreads; i++)
+  {
+    pthread_join(manager->decoderThreads[i], NULL);
+  }
+
+  // Anything decoded but never uploaded still owns CPU memory
+  for (int i = 0; i < manager->requestCount; i++)
+  {
+    AssetRequest *request = &manager->requests[i];
+    if (request->state != ASSET_DECODED || request->fromBundle)
+      continue;
+
+    if (request->isImage)
+      UnloadImage(request->image);
+    else
+      UnloadWave(request->wave);
+  }
+
+  closeAssetBundle(manager->bundle);
+  pthread_mutex_destroy(&manager->mutex);
+  pthread_cond_destroy(&manager->requestAdded);
+  trackedFree(manager->decoderThreads);
+  trackedFree(manager->requests);
+  trackedFree(manager);
+}
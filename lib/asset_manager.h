@@ -0,0 +1,19 @@
+#include "asset_manager.c"
+
+AssetManager *createAssetManager(int maxRequests, int numDecoderThreads,
+                                 const char *bundlePath);
+
+void queueAsset(AssetManager *manager, const char *path, bool isImage);
+
+void uploadDecodedAssets(AssetManager *manager, double budgetSeconds);
+
+float getAssetLoadingProgress(AssetManager *manager);
+
+bool areAssetsLoaded(AssetManager *manager);
+
+bool getLoadedSound(AssetManager *manager, const char *path, Sound *sound);
+
+bool getLoadedTexture(AssetManager *manager, const char *path,
+                      Texture2D *texture);
+
+void destroyAssetManager(AssetManager *manager);
@@ -0,0 +1,119 @@
+#include <raylib.h>
+#include <stdlib.h>
+
+// A zeroed column, or NULL if the archetype doesn't have the component
+void *allocateColumn(int components, int component, int capacity, size_t size)
+{
+  if ((components & component) == 0)
+    return NULL;
+
+  return trackedCalloc(MEMORY_ENTITIES, capacity, size);
+}
+
+// Allocates a column for each of the archetype's components, with every slot
+// starting out free
+void initializeArchetype(EntityArchetype *archetype, int components,
+                         int capacity)
+{
+  archetype->components = components;
+  archetype->capacity = capacity;
+  archetype->liveCount = 0;
+
+  archetype->live = trackedMalloc(MEMORY_ENTITIES, capacity * sizeof(int));
+  archetype->liveIndex =
+      trackedMalloc(MEMORY_ENTITIES, capacity * sizeof(int));
+
+  for (int i = 0; i < capacity; i++)
+  {
+    archetype->live[i] = i;
+    archetype->liveIndex[i] = i;
+  }
+
+  archetype->positions = allocateColumn(components, COMPONENT_POSITION,
+                                        capacity, sizeof(Vector2));
+  archetype->sizes =
+      allocateColumn(components, COMPONENT_SIZE, capacity, sizeof(Vector2));
+  archetype->speeds =
+      allocateColumn(components, COMPONENT_MOTION, capacity, sizeof(int));
+  archetype->damages =
+      allocateColumn(components, COMPONENT_MOTION, capacity, sizeof(float));
+  archetype->sounds =
+      allocateColumn(components, COMPONENT_SOUND, capacity, sizeof(Sound));
+  archetype->velocities = allocateColumn(components, COMPONENT_VELOCITY,
+                                         capacity, sizeof(Vector2));
+  archetype->lifetimes =
+      allocateColumn(components, COMPONENT_VELOCITY, capacity, sizeof(int));
+  archetype->owners =
+      allocateColumn(components, COMPONENT_OWNER, capacity, sizeof(int));
+}
+
+bool isEntityAlive(EntityArchetype *archetype, int slot)
+{
+  return archetype->liveIndex[slot] < archetype->liveCount;
+}
+
+void swapLiveEntities(EntityArchetype *archetype, int a, int b)
+{
+  int slotA = archetype->live[a];
+  int slotB = archetype->live[b];
+
+  archetype->live[a] = slotB;
+  archetype->live[b] = slotA;
+  archetype->liveIndex[slotA] = b;
+  archetype->liveIndex[slotB] = a;
+}
+
+// Brings a particular slot to life, for mirroring another game's entities
+void addEntityAt(EntityArchetype *archetype, int slot)
+{
+  if (isEntityAlive(archetype, slot))
+    return;
+
+  swapLiveEntities(archetype, archetype->liveIndex[slot],
+                   archetype->liveCount);
+  archetype->liveCount++;
+}
+
+// Returns the slot of a new entity, or -1 if the archetype is full. Its
+// columns hold whatever the slot's last entity left there.
+int addEntity(EntityArchetype *archetype)
+{
+  if (archetype->liveCount == archetype->capacity)
+    return -1;
+
+  int slot = archetype->live[archetype->liveCount];
+  archetype->liveCount++;
+
+  return slot;
+}
+
+// The last live entity takes the removed one's place in live, so removing
+// while walking live backwards visits everything once
+void removeEntity(EntityArchetype *archetype, int slot)
+{
+  if (!isEntityAlive(archetype, slot))
+    return;
+
+  archetype->liveCount--;
+  swapLiveEntities(archetype, archetype->liveIndex[slot],
+                   archetype->liveCount);
+}
+
+void clearEntities(EntityArchetype *archetype)
+{
+  archetype->liveCount = 0;
+}
+
+void destroyArchetype(EntityArchetype *archetype)
+{
+  trackedFree(archetype->live);
+  trackedFree(archetype->liveIndex);
+  trackedFree(archetype->positions);
+  trackedFree(archetype->sizes);
+  trackedFree(archetype->speeds);
+  trackedFree(archetype->damages);
+  trackedFree(archetype->sounds);
+  trackedFree(archetype->velocities);
+  trackedFree(archetype->lifetimes);
+  trackedFree(archetype->owners);
+}
@@ -0,0 +1,20 @@
+#include "entity_store.c"
+
+void *allocateColumn(int components, int component, int capacity, size_t size);
+
+void initializeArchetype(EntityArchetype *archetype, int components,
+                         int capacity);
+
+bool isEntityAlive(EntityArchetype *archetype, int slot);
+
+void swapLiveEntities(EntityArchetype *archetype, int a, int b);
+
+void addEntityAt(EntityArchetype *archetype, int slot);
+
+int addEntity(EntityArchetype *archetype);
+
+void removeEntity(EntityArchetype *archetype, int slot);
+
+void clearEntities(EntityArchetype *archetype);
+
+void destroyArchetype(EntityArchetype *archetype);
@@ -0,0 +1,271 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Instances stepped per job part
+#define ENV_BATCH_SIZE 8
+
+#define ENV_OBSERVED_ENEMIES 4
+#define ENV_GLOBAL_OBSERVATIONS 4
+// Position and health, then (dx, dy, present) for each of the closest enemies
+// and the closest solar cell
+#define ENV_PLAYER_OBSERVATIONS (3 + ENV_OBSERVED_ENEMIES * 3 + 3)
+
+#define ENV_KILL_REWARD 1.0f
+#define ENV_DAMAGE_PENALTY 0.01f // per point of health lost
+#define ENV_END_REWARD 10.0f     // won, or lost as a penalty
+
+int getGameEnvObservationSize(GameEnv *env)
+{
+  return env->observationSize;
+}
+
+void writeGameObservation(Game *game, float *observation)
+{
+  float halfMap = game->mapSize / 2.0f;
+
+  *observation++ = game->battery;
+  *observation++ = game->solarCellsCollected / 10.0f;
+  *observation++ = (float)game->enemyCount / game->maxEnemies;
+  *observation++ = (float)game->currentWave / game->numWaves;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Player *player = &game->players[i];
+
+    *observation++ = player->position.x / halfMap;
+    *observation++ = player->position.y / halfMap;
+    *observation++ = player->health / 100;
+
+    // Closest enemies, nearest first
+    int closest[ENV_OBSERVED_ENEMIES];
+    float distances[ENV_OBSERVED_ENEMIES];
+    int found = 0;
+
+    EntityArchetype *enemies = &game->enemies;
+
+    for (int j = 0; j < enemies->liveCount; j++)
+    {
+      int slot = enemies->live[j];
+      float distance = getDistanceBetweenVectors(player->position,
+                                                 enemies->positions[slot]);
+      if (found == ENV_OBSERVED_ENEMIES &&
+          distance >= distances[ENV_OBSERVED_ENEMIES - 1])
+        continue;
+
+      int k = found < ENV_OBSERVED_ENEMIES ? found++ : found - 1;
+      while (k > 0 && distances[k - 1] > distance)
+      {
+        closest[k] = closest[k - 1];
+        distances[k] = distances[k - 1];
+        k--;
+      }
+      closest[k] = slot;
+      distances[k] = distance;
+    }
+
+    for (int k = 0; k < ENV_OBSERVED_ENEMIES; k++)
+    {
+      if (k < found)
+      {
+        Vector2 position = enemies->positions[closest[k]];
+        *observation++ = (position.x - player->position.x) / game->gunRange;
+        *observation++ = (position.y - player->position.y) / game->gunRange;
+        *observation++ = 1;
+      }
+      else
+      {
+        *observation++ = 0;
+        *observation++ = 0;
+        *observation++ = 0;
+      }
+    }
+
+    int closestCell = -1;
+    float closestCellDistance = 0;
+
+    EntityArchetype *cells = &game->solarCells;
+
+    for (int j = 0; j < cells->liveCount; j++)
+    {
+      int slot = cells->live[j];
+      float distance = getDistanceBetweenVectors(player->position,
+                                                 cells->positions[slot]);
+      if (closestCell == -1 || distance < closestCellDistance)
+      {
+        closestCell = slot;
+        closestCellDistance = distance;
+      }
+    }
+
+    if (closestCell != -1)
+    {
+      Vector2 position = cells->positions[closestCell];
+      *observation++ = (position.x - player->position.x) / halfMap;
+      *observation++ = (position.y - player->position.y) / halfMap;
+      *observation++ = 1;
+    }
+    else
+    {
+      *observation++ = 0;
+      *observation++ = 0;
+      *observation++ = 0;
+    }
+  }
+}
+
+float getTotalHealth(Game *game)
+{
+  float health = 0;
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    health += game->players[i].health;
+  }
+  return health;
+}
+
+void resetGameEnvInstance(GameEnv *env, int index)
+{
+  Game *game = &env->games[index];
+
+  restartGame(game);
+  env->lastHealth[index] = getTotalHealth(game);
+  env->lastKills[index] = game->enemiesKilled;
+}
+
+// Steps one game. Finished games are restarted straight away, so the
+// observation written is already the first of the next match.
+void stepGameEnvInstance(GameEnv *env, int index)
+{
+  Game *game = &env->games[index];
+  const PlayerInput *inputs = &env->inputs[index * env->playerCount];
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    game->playerInputs[i] = inputs[i];
+  }
+
+  stepGame(game);
+
+  float health = getTotalHealth(game);
+  float reward =
+      (game->enemiesKilled - env->lastKills[index]) * ENV_KILL_REWARD -
+      (env->lastHealth[index] - health) * ENV_DAMAGE_PENALTY;
+
+  env->lastHealth[index] = health;
+  env->lastKills[index] = game->enemiesKilled;
+
+  bool done = game->gameOver || game->gameWon;
+  if (game->gameWon)
+    reward += ENV_END_REWARD;
+  else if (game->gameOver)
+    reward -= ENV_END_REWARD;
+
+  if (done)
+    resetGameEnvInstance(env, index);
+
+  env->rewards[index] = reward;
+  env->dones[index] = done;
+  writeGameObservation(game,
+                       &env->observations[index * env->observationSize]);
+}
+
+void stepGameEnvBatchJob(void *data, int index)
+{
+  GameEnv *env = (GameEnv *)data;
+  int start = index * ENV_BATCH_SIZE;
+  int end = start + ENV_BATCH_SIZE;
+  if (end > env->instanceCount)
+    end = env->instanceCount;
+
+  for (int i = start; i < end; i++)
+  {
+    stepGameEnvInstance(env, i);
+  }
+}
+
+// Creates instanceCount headless games of playerCount players each, stepped
+// by workerCount threads plus the caller, or one per core if workerCount is
+// -1. Instance i is seeded with seed + i.
+GameEnv *createGameEnv(int instanceCount, int playerCount, int workerCount,
+                       unsigned int seed)
+{
+  if (instanceCount < 1 || playerCount < 1 || playerCount > MAX_PLAYERS)
+  {
+    printf("ERROR: Invalid environment size\n");
+    return NULL;
+  }
+
+  GameEnv *env = trackedCalloc(MEMORY_ENTITIES, 1, sizeof(GameEnv));
+  env->instanceCount = instanceCount;
+  env->playerCount = playerCount;
+  env->observationSize =
+      ENV_GLOBAL_OBSERVATIONS + playerCount * ENV_PLAYER_OBSERVATIONS;
+
+  env->games =
+      trackedAlignedCalloc(MEMORY_ENTITIES, instanceCount, sizeof(Game));
+  env->lastHealth =
+      trackedCalloc(MEMORY_ENTITIES, instanceCount, sizeof(float));
+  env->lastKills = trackedCalloc(MEMORY_ENTITIES, instanceCount, sizeof(int));
+
+  for (int i = 0; i < instanceCount; i++)
+  {
+    Game *game = &env->games[i];
+
+    setDefaultGameSettings(game);
+    game->headless = true;
+    game->playerCount = playerCount;
+    game->randomState = seed + i;
+
+    initializeSimulation(game);
+    resetGameEnvInstance(env, i);
+  }
+
+  env->jobs = createJobSystem(workerCount);
+
+  return env;
+}
+
+// Restarts every game and writes its first observation
+void resetGameEnv(GameEnv *env, float *observations)
+{
+  for (int i = 0; i < env->instanceCount; i++)
+  {
+    resetGameEnvInstance(env, i);
+    writeGameObservation(&env->games[i],
+                         &observations[i * env->observationSize]);
+  }
+}
+
+// Advances every game by one frame in lock-step.
+//   inputs       instanceCount * playerCount, grouped by instance
+//   observations instanceCount * getGameEnvObservationSize(env)
+//   rewards      instanceCount, summed over the instance's players
+//   dones        instanceCount, true where a match ended and was restarted
+void stepGameEnv(GameEnv *env, const PlayerInput *inputs, float *observations,
+                 float *rewards, bool *dones)
+{
+  env->inputs = inputs;
+  env->observations = observations;
+  env->rewards = rewards;
+  env->dones = dones;
+
+  runJob(env->jobs, "step games", stepGameEnvBatchJob, env,
+         (env->instanceCount + ENV_BATCH_SIZE - 1) / ENV_BATCH_SIZE);
+}
+
+void destroyGameEnv(GameEnv *env)
+{
+  destroyJobSystem(env->jobs);
+
+  for (int i = 0; i < env->instanceCount; i++)
+  {
+    destroySimulation(&env->games[i]);
+  }
+
+  trackedFree(env->games);
+  trackedFree(env->lastHealth);
+  trackedFree(env->lastKills);
+  trackedFree(env);
+}
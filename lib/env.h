@@ -0,0 +1,13 @@
+#include "env.c"
+
+int getGameEnvObservationSize(GameEnv *env);
+
+GameEnv *createGameEnv(int instanceCount, int playerCount, int workerCount,
+                       unsigned int seed);
+
+void resetGameEnv(GameEnv *env, float *observations);
+
+void stepGameEnv(GameEnv *env, const PlayerInput *inputs, float *observations,
+                 float *rewards, bool *dones);
+
+void destroyGameEnv(GameEnv *env);
@@ -0,0 +1,1527 @@
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOLAR_CELL_SIZE 20
+#define ENEMY_SIZE 70
+
+#define PROJECTILE_SIZE 8
+#define PROJECTILE_SPEED 1200 // units per second
+
+// Enemy grid cells hold a couple of enemies, so a bolt's sweep checks only
+// the few around it
+#define ENEMY_GRID_SIZE 100
+
+// Grid cells the size of a player, so a pickup checks at most a 3x3 block
+#define SOLAR_CELL_GRID_SIZE 100
+
+// Enemies far from every player are simulated less often and more coarsely.
+// Near ones are on screen and get the full update every tick, mid ones are
+// within this margin past the edge of the view.
+#define ENEMY_MID_MARGIN 800
+#define ENEMY_MID_TICKS 2 // ticks between mid tier updates
+#define ENEMY_FAR_TICKS 8
+#define ENEMY_TIER_TICKS 8 // ticks to reassign every enemy's tier
+
+// Spawn points are a Poisson-disk pattern an enemy apart, repeated in every
+// world chunk
+#define SPAWN_SPACING ENEMY_SIZE
+#define SPAWN_TILE_SIZE (16 * SPAWN_SPACING)
+#define SPAWN_TILE_CELLS 24 // a cell's diagonal is under the spacing
+#define MAX_SPAWN_PATTERN_POINTS 512
+#define SPAWN_PATTERN_CANDIDATES 30
+
+#define SPAWN_PLAYER_CLEARANCE 500
+#define SPAWN_ATTEMPTS 4 // spawn points tried per enemy before giving up
+
+// Chunks within the active range of a player are loaded, and stay loaded
+// until they are past the evict range, so walking along a border doesn't
+// load and evict the same chunk over and over
+#define WORLD_CHUNK_SIZE SPAWN_TILE_SIZE // one spawn pattern tile each
+#define WORLD_ACTIVE_RANGE 1500
+#define WORLD_EVICT_RANGE 2500
+#define WORLD_UPDATE_TICKS 15
+#define SOLAR_CELLS_PER_CHUNK 5
+
+// Each game keeps its own random state so many can run side by side and
+// replay the same way from a seed
+int gameRandom(Game *game)
+{
+  return rand_r(&game->randomState);
+}
+
+// Shared by every game without an audio device, all of its sounds are NULL
+GameSound silentSound;
+
+void playMultiSound(MultiSound *multiSound)
+{
+  // Headless games never load sounds
+  if (multiSound == NULL)
+    return;
+
+  PlaySound(multiSound->buffer[multiSound->currentBuff]);
+  multiSound->currentBuff =
+      (multiSound->currentBuff + 1) % multiSound->buffsize;
+}
+
+void updateMessage(Game *game)
+{
+  game->messageOpacity =
+      1 - ((float)(game->frameCount - game->messageAddedFrame) /
+           (game->messageDuration * game->targetFPS));
+
+  if (game->messageOpacity > 1)
+    game->messageOpacity = 1;
+  if (game->messageOpacity < 0)
+    game->messageOpacity = 0;
+}
+
+void showMessage(Game *game, char message[], int fontSize)
+{
+  sprintf(game->message, "%s", message);
+  game->messageFontSize = fontSize;
+  game->messageAddedFrame = game->frameCount;
+  game->messageOpacity = 1;
+}
+
+// Adds one frame's worth of charge from live chargers [start, end)
+void chargeBattery(Game *game, int start, int end)
+{
+  EntityArchetype *chargers = &game->solarChargers;
+  float charge = 0;
+
+  if (end > chargers->liveCount)
+    end = chargers->liveCount;
+
+  for (int i = start; i < end; i++)
+  {
+    Vector2 size = chargers->sizes[chargers->live[i]];
+    charge += (size.x * size.y / 100000) / game->targetFPS;
+  }
+
+  // Charge the battery once for the whole range
+  lockTracedMutex(&game->batteryMutex, "battery");
+  game->battery += charge;
+  pthread_mutex_unlock(&game->batteryMutex);
+}
+
+void initializeSolarChargers(Game *game)
+{
+  initializeArchetype(&game->solarChargers,
+                      COMPONENT_POSITION | COMPONENT_SIZE,
+                      game->maxSolarChargers);
+  initializeObstacleTree(&game->chargerTree, game->maxSolarChargers);
+}
+
+// Chargers stand centred on their position
+Rectangle getChargerBox(Game *game, int slot)
+{
+  Vector2 position = game->solarChargers.positions[slot];
+  Vector2 size = game->solarChargers.sizes[slot];
+
+  return (Rectangle){position.x - size.x / 2, position.y - size.y / 2, size.x,
+                     size.y};
+}
+
+// Refills the charger tree, for when the chargers were replaced as a whole
+void rebuildChargerTree(Game *game)
+{
+  EntityArchetype *chargers = &game->solarChargers;
+
+  clearObstacleTree(&game->chargerTree);
+  for (int i = 0; i < chargers->liveCount; i++)
+  {
+    int slot = chargers->live[i];
+    insertObstacle(&game->chargerTree, slot, getChargerBox(game, slot));
+  }
+}
+
+#define MAX_CHARGER_HITS 16
+
+// Cuts velocity short where a square mover of the given size would run into
+// a charger, one axis at a time so it slides along the charger's side.
+// Chargers it already overlaps, like one built on top of it, don't block it.
+Vector2 slideAgainstChargers(Game *game, Vector2 position, float size,
+                             Vector2 velocity)
+{
+  float half = size / 2;
+  Rectangle box = {position.x - half, position.y - half, size, size};
+  Rectangle hits[MAX_CHARGER_HITS];
+
+  Rectangle moved = {box.x + velocity.x, box.y, size, size};
+  int hitCount =
+      queryObstacleTree(&game->chargerTree, moved, hits, MAX_CHARGER_HITS);
+
+  for (int i = 0; i < hitCount; i++)
+  {
+    if (CheckCollisionRecs(box, hits[i]))
+      continue;
+
+    if (velocity.x > 0)
+      velocity.x = fmaxf(fminf(velocity.x, hits[i].x - (box.x + size)), 0);
+    else
+      velocity.x =
+          fminf(fmaxf(velocity.x, hits[i].x + hits[i].width - box.x), 0);
+  }
+  box.x += velocity.x;
+
+  moved = (Rectangle){box.x, box.y + velocity.y, size, size};
+  hitCount =
+      queryObstacleTree(&game->chargerTree, moved, hits, MAX_CHARGER_HITS);
+
+  for (int i = 0; i < hitCount; i++)
+  {
+    if (CheckCollisionRecs(box, hits[i]))
+      continue;
+
+    if (velocity.y > 0)
+      velocity.y = fmaxf(fminf(velocity.y, hits[i].y - (box.y + size)), 0);
+    else
+      velocity.y =
+          fminf(fmaxf(velocity.y, hits[i].y + hits[i].height - box.y), 0);
+  }
+
+  return velocity;
+}
+
+void buildSolarCharger(Game *game, Vector2 position, int size)
+{
+  lockTracedMutex(&game->solarCellsMutex, "solar cells");
+  bool affordable = game->solarCellsCollected >= size * 10;
+  if (affordable)
+    game->solarCellsCollected -= size * 10;
+  pthread_mutex_unlock(&game->solarCellsMutex);
+
+  if (!affordable)
+  {
+    emitGameEvent(game, GAME_EVENT_NOT_ENOUGH_CELLS, -1, -1, position);
+    return;
+  }
+
+  int slot = addEntity(&game->solarChargers);
+  if (slot != -1)
+  {
+    game->solarChargers.positions[slot] = position;
+    game->solarChargers.sizes[slot] = (Vector2){size * 100, 100};
+    placeMinimapEntity(&game->minimap, MINIMAP_CHARGER, slot, position);
+    insertObstacle(&game->chargerTree, slot, getChargerBox(game, slot));
+
+    emitGameEvent(game, GAME_EVENT_CHARGER_BUILT, -1, slot, position);
+  }
+}
+
+// In initializePlayers function:
+void initializePlayers(Game *game)
+{
+  Color playerColors[MAX_PLAYERS] = {YELLOW, BLUE,   GREEN,   PINK,
+                                    ORANGE, PURPLE, SKYBLUE, RED};
+
+  game->players =
+      trackedAlignedCalloc(MEMORY_ENTITIES, game->playerCount, sizeof(Player));
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    game->players[i].size = 100;
+    game->players[i].flipDir = 1;
+    game->players[i].speed = (float)600 / game->targetFPS;
+    game->players[i].health = 100;
+    game->players[i].color = playerColors[i % MAX_PLAYERS];
+    game->players[i].position =
+        (Vector2){0 + i * (20 + game->players[i].size), 0};
+
+    if (pthread_mutex_init(&game->players[i].mutex, NULL))
+    {
+      exit(0);
+    };
+  }
+}
+
+// Closest enemy within range of from, -1 if none. Only looks through the
+// enemy grid cells the range covers, so the grid must be indexed.
+int getClosestEnemyIndex(Game *game, Vector2 from, float range)
+{
+  EntityArchetype *enemies = &game->enemies;
+  SpatialGrid *grid = &game->enemyGrid;
+  float shortestDistance = INT_MAX;
+  int closestEnemyIndex = -1;
+
+  int minColumn, minRow, maxColumn, maxRow;
+  getGridCellRange(grid,
+                   (Rectangle){from.x - range, from.y - range, range * 2,
+                               range * 2},
+                   &minColumn, &minRow, &maxColumn, &maxRow);
+
+  for (int row = minRow; row <= maxRow; row++)
+  {
+    for (int column = minColumn; column <= maxColumn; column++)
+    {
+      int slot = grid->heads[row * grid->columns + column];
+
+      for (; slot != -1; slot = grid->next[slot])
+      {
+        if (!isEntityAlive(enemies, slot))
+          continue;
+
+        float distance =
+            getDistanceBetweenVectors(enemies->positions[slot], from);
+        if (distance <= range && distance < shortestDistance)
+        {
+          shortestDistance = distance;
+          closestEnemyIndex = slot;
+        }
+      }
+    }
+  }
+
+  return closestEnemyIndex;
+}
+
+void initializeEnemies(Game *game)
+{
+  initializeArchetype(&game->enemies,
+                      COMPONENT_POSITION | COMPONENT_SIZE | COMPONENT_MOTION |
+                          COMPONENT_SOUND,
+                      game->maxEnemies);
+  initializeSpatialGrid(&game->enemyGrid,
+                        (Vector2){-game->mapSize / 2.0f, -game->mapSize / 2.0f},
+                        game->mapSize, ENEMY_GRID_SIZE, game->maxEnemies);
+  game->enemyPositions =
+      trackedCalloc(MEMORY_ENTITIES, game->maxEnemies, sizeof(Vector2));
+  game->enemyTiers = trackedCalloc(MEMORY_ENTITIES, game->maxEnemies,
+                                   sizeof(unsigned char));
+  game->enemyTierCursor = 0;
+}
+
+void initializeProjectiles(Game *game)
+{
+  initializeArchetype(&game->projectiles,
+                      COMPONENT_POSITION | COMPONENT_SIZE | COMPONENT_VELOCITY |
+                          COMPONENT_OWNER,
+                      game->maxProjectiles);
+  game->projectileHits =
+      trackedCalloc(MEMORY_ENTITIES, game->maxProjectiles, sizeof(int));
+}
+
+// Read-only, every game in the process points at the same table
+const EnemyWave waveTable[] = {
+    {5, 10},
+    {25, 40},
+    {50, 80},
+};
+
+void initializeWaves(Game *game)
+{
+  game->waves = waveTable;
+  game->numWaves = sizeof(waveTable) / sizeof(waveTable[0]);
+
+  game->lastWaveFrame = 0;
+  game->currentWave = 0;
+  game->frameCount = 0;
+}
+
+void initializeSolarCells(Game *game)
+{
+  initializeArchetype(&game->solarCells, COMPONENT_POSITION | COMPONENT_SIZE,
+                      game->maxSolarCells);
+  initializeSpatialGrid(&game->solarCellGrid,
+                        (Vector2){-game->mapSize / 2.0f, -game->mapSize / 2.0f},
+                        game->mapSize, SOLAR_CELL_GRID_SIZE,
+                        game->maxSolarCells);
+}
+
+void addSolarCell(Game *game, Vector2 position)
+{
+
+  lockTracedMutex(&game->solarCellsMutex, "solar cells");
+  int slot = addEntity(&game->solarCells);
+  if (slot != -1)
+  {
+    game->solarCells.positions[slot] = position;
+    game->solarCells.sizes[slot] = (Vector2){SOLAR_CELL_SIZE, SOLAR_CELL_SIZE};
+    insertGridEntry(&game->solarCellGrid, slot, position);
+    placeMinimapEntity(&game->minimap, MINIMAP_CELL, slot, position);
+  }
+  pthread_mutex_unlock(&game->solarCellsMutex);
+}
+
+void removeSolarCell(Game *game, int cellIndex)
+{
+
+  removeGridEntry(&game->solarCellGrid, cellIndex);
+  removeMinimapEntity(&game->minimap, MINIMAP_CELL, cellIndex);
+  removeEntity(&game->solarCells, cellIndex);
+}
+
+void collectSolarCells(Game *game, Player *player)
+{
+  EntityArchetype *cells = &game->solarCells;
+  SpatialGrid *grid = &game->solarCellGrid;
+  Rectangle playerRect = {player->position.x - (float)player->size / 2,
+                          player->position.y - (float)player->size / 2,
+                          player->size, player->size};
+
+  // Only the grid cells under the player can hold a cell it touches
+  int minColumn, minRow, maxColumn, maxRow;
+  getGridCellRange(grid,
+                   (Rectangle){playerRect.x - SOLAR_CELL_SIZE / 2.0f,
+                               playerRect.y - SOLAR_CELL_SIZE / 2.0f,
+                               playerRect.width + SOLAR_CELL_SIZE,
+                               playerRect.height + SOLAR_CELL_SIZE},
+                   &minColumn, &minRow, &maxColumn, &maxRow);
+
+  for (int row = minRow; row <= maxRow; row++)
+  {
+    for (int column = minColumn; column <= maxColumn; column++)
+    {
+      int slot = grid->heads[row * grid->columns + column];
+
+      while (slot != -1)
+      {
+        int next = grid->next[slot];
+        Vector2 position = cells->positions[slot];
+        Vector2 size = cells->sizes[slot];
+
+        if (CheckCollisionRecs(playerRect,
+                               (Rectangle){position.x - size.x / 2,
+                                           position.y - size.y / 2, size.x,
+                                           size.y}))
+        {
+          // Cells are only added and removed under the lock, make sure
+          // this one is still there once we hold it
+          lockTracedMutex(&game->solarCellsMutex, "solar cells");
+          if (isEntityAlive(cells, slot))
+          {
+            // Remove Solar Cell
+            game->solarCellsCollected++;
+            emitGameEvent(game, GAME_EVENT_CELL_PICKED, player - game->players,
+                          slot, position);
+            removeSolarCell(game, slot);
+          }
+          pthread_mutex_unlock(&game->solarCellsMutex);
+        }
+
+        slot = next;
+      }
+    }
+  }
+}
+
+// Enemies collide against where the others were at the start of the frame,
+// so any range of them can be updated alongside the rest
+void snapshotEnemyPositions(Game *game)
+{
+  EntityArchetype *enemies = &game->enemies;
+
+  for (int i = 0; i < enemies->liveCount; i++)
+  {
+    game->enemyPositions[i] = enemies->positions[enemies->live[i]];
+  }
+}
+
+// The player nearest to position, and how far away it is
+Player *getClosestPlayer(Game *game, Vector2 position, float *distance)
+{
+  Player *closestPlayer = NULL;
+  float shortestDistance = INT_MAX;
+
+  for (int j = 0; j < game->playerCount; j++)
+  {
+    lockTracedMutex(&game->players[j].mutex, "player");
+
+    float playerDistance =
+        getDistanceBetweenVectors(position, game->players[j].position);
+
+    if (playerDistance < shortestDistance)
+    {
+      shortestDistance = playerDistance;
+      closestPlayer = &game->players[j];
+    }
+    pthread_mutex_unlock(&game->players[j].mutex);
+  }
+
+  *distance = shortestDistance;
+  return closestPlayer;
+}
+
+// Distance from a player within which an enemy may be on screen: the
+// corner of the widest view, plus the enemy poking in over its edge
+float getEnemyNearRange(Game *game)
+{
+  return getVectorMagnitude(game->viewHalfExtent) + ENEMY_SIZE;
+}
+
+int getEnemyTier(Game *game, Vector2 position)
+{
+  float distance;
+  getClosestPlayer(game, position, &distance);
+
+  float nearRange = getEnemyNearRange(game);
+  if (distance < nearRange)
+    return ENEMY_TIER_NEAR;
+  if (distance < nearRange + ENEMY_MID_MARGIN)
+    return ENEMY_TIER_MID;
+  return ENEMY_TIER_FAR;
+}
+
+// Reassigns a slice of the enemies each tick, so every one is looked at
+// again within ENEMY_TIER_TICKS without a pass over all of them
+void updateEnemyTiers(Game *game)
+{
+  EntityArchetype *enemies = &game->enemies;
+  int count = (enemies->liveCount + ENEMY_TIER_TICKS - 1) / ENEMY_TIER_TICKS;
+
+  for (int n = 0; n < count; n++)
+  {
+    if (game->enemyTierCursor >= enemies->liveCount)
+      game->enemyTierCursor = 0;
+
+    int slot = enemies->live[game->enemyTierCursor++];
+    game->enemyTiers[slot] = getEnemyTier(game, enemies->positions[slot]);
+  }
+}
+
+// Pushes an enemy off the others filed around it in the enemy grid, where
+// they stood at the end of last tick or where they spawned since
+bool separateEnemy(Game *game, int slot, Vector2 *position, float radius,
+                   float step)
+{
+  EntityArchetype *enemies = &game->enemies;
+  SpatialGrid *grid = &game->enemyGrid;
+  bool colliding = false;
+
+  int minColumn, minRow, maxColumn, maxRow;
+  getGridCellRange(grid,
+                   (Rectangle){position->x - radius * 2,
+                               position->y - radius * 2, radius * 4,
+                               radius * 4},
+                   &minColumn, &minRow, &maxColumn, &maxRow);
+
+  for (int row = minRow; row <= maxRow; row++)
+  {
+    for (int column = minColumn; column <= maxColumn; column++)
+    {
+      int enemy = grid->heads[row * grid->columns + column];
+
+      for (; enemy != -1; enemy = grid->next[enemy])
+      {
+        if (enemy == slot || !isEntityAlive(enemies, enemy))
+          continue;
+
+        Vector2 other = game->enemyPositions[enemies->liveIndex[enemy]];
+        if (CheckCollisionCircles(*position, radius, other,
+                                  enemies->sizes[enemy].x * 0.55))
+        {
+          colliding = true;
+          Vector2 direction = getDirectionVector2s(other, *position);
+
+          position->x += direction.x * (step * 0.5);
+          position->y += direction.y * (step * 0.5);
+        }
+      }
+    }
+  }
+
+  return colliding;
+}
+
+// Moves the live enemies [start, end) towards their closest player. Mid
+// and far tier enemies only move every few ticks, but by that many ticks'
+// worth, so they keep the same pace.
+void updateEnemyRange(Game *game, int start, int end)
+{
+  EntityArchetype *enemies = &game->enemies;
+
+  if (end > enemies->liveCount)
+    end = enemies->liveCount;
+
+  for (int k = start; k < end; k++)
+  {
+    int i = enemies->live[k];
+    int tier = game->enemyTiers[i];
+
+    // Spread each tier's updates evenly over its ticks
+    int ticks = 1;
+    if (tier == ENEMY_TIER_MID)
+      ticks = ENEMY_MID_TICKS;
+    else if (tier == ENEMY_TIER_FAR)
+      ticks = ENEMY_FAR_TICKS;
+    if ((game->frameCount + i) % ticks != 0)
+      continue;
+
+    Vector2 *position = &enemies->positions[i];
+    float step = enemies->speeds[i] * ticks;
+
+    float shortestDistance;
+    Player *closestPlayer =
+        getClosestPlayer(game, *position, &shortestDistance);
+
+    // if close enough to player, stop and give him damage
+    if (shortestDistance < (float)closestPlayer->size)
+    {
+      lockTracedMutex(&closestPlayer->mutex, "player");
+      closestPlayer->health -= enemies->damages[i] / game->targetFPS;
+      pthread_mutex_unlock(&closestPlayer->mutex);
+
+      continue;
+    }
+
+    // Getting direction to the closest player
+    Vector2 direction =
+        getDirectionVector2s(*position, closestPlayer->position);
+
+    Vector2 velocity = (Vector2){direction.x * step, direction.y * step};
+    velocity =
+        slideAgainstChargers(game, *position, enemies->sizes[i].x, velocity);
+
+    position->x += velocity.x;
+    position->y += velocity.y;
+
+    // Far enemies are off screen, nothing is there to see them overlap
+    bool colliding = false;
+    float radius = enemies->sizes[i].x * 0.55;
+    if (tier != ENEMY_TIER_FAR)
+      colliding = separateEnemy(game, i, position, radius, step);
+
+    // Undo the move made earlier if colliding
+    if (colliding)
+    {
+      position->x -= velocity.x;
+      position->y -= velocity.y;
+    }
+
+    placeMinimapEntity(&game->minimap, MINIMAP_ENEMY, i, *position);
+  }
+}
+
+// Read-only once built, every game in the process shares the same tile
+Vector2 spawnPattern[MAX_SPAWN_PATTERN_POINTS];
+int spawnPatternCount;
+pthread_once_t spawnPatternOnce = PTHREAD_ONCE_INIT;
+
+float getSpawnRandom(unsigned int *seed)
+{
+  return (float)rand_r(seed) / RAND_MAX;
+}
+
+// Bridson's Poisson-disk sampling on a tile that wraps around at the edges,
+// so tiles laid side by side keep the spacing across their borders too
+void buildSpawnPattern(void)
+{
+  unsigned int seed = 1; // the same pattern in every run
+  float cellSize = (float)SPAWN_TILE_SIZE / SPAWN_TILE_CELLS;
+  int cells[SPAWN_TILE_CELLS * SPAWN_TILE_CELLS];
+  int active[MAX_SPAWN_PATTERN_POINTS];
+  int activeCount = 0;
+
+  for (int i = 0; i < SPAWN_TILE_CELLS * SPAWN_TILE_CELLS; i++)
+  {
+    cells[i] = -1;
+  }
+
+  Vector2 point = {getSpawnRandom(&seed) * SPAWN_TILE_SIZE,
+                   getSpawnRandom(&seed) * SPAWN_TILE_SIZE};
+
+  while (true)
+  {
+    int column = (int)(point.x / cellSize) % SPAWN_TILE_CELLS;
+    int row = (int)(point.y / cellSize) % SPAWN_TILE_CELLS;
+    cells[row * SPAWN_TILE_CELLS + column] = spawnPatternCount;
+    active[activeCount++] = spawnPatternCount;
+    spawnPattern[spawnPatternCount++] = point;
+
+    if (spawnPatternCount == MAX_SPAWN_PATTERN_POINTS)
+      return;
+
+    // Look for room around a random active point, retiring full ones
+    bool found = false;
+    while (!found && activeCount > 0)
+    {
+      int i = rand_r(&seed) % activeCount;
+      Vector2 origin = spawnPattern[active[i]];
+
+      for (int k = 0; k < SPAWN_PATTERN_CANDIDATES && !found; k++)
+      {
+        float angle = getSpawnRandom(&seed) * 2 * PI;
+        float distance = SPAWN_SPACING * (1 + getSpawnRandom(&seed));
+        point.x = fmodf(origin.x + cosf(angle) * distance + SPAWN_TILE_SIZE,
+                        SPAWN_TILE_SIZE);
+        point.y = fmodf(origin.y + sinf(angle) * distance + SPAWN_TILE_SIZE,
+                        SPAWN_TILE_SIZE);
+
+        int column = (int)(point.x / cellSize);
+        int row = (int)(point.y / cellSize);
+        found = true;
+
+        for (int dy = -2; dy <= 2 && found; dy++)
+        {
+          for (int dx = -2; dx <= 2 && found; dx++)
+          {
+            int neighbour =
+                cells[((row + dy + SPAWN_TILE_CELLS) % SPAWN_TILE_CELLS) *
+                          SPAWN_TILE_CELLS +
+                      (column + dx + SPAWN_TILE_CELLS) % SPAWN_TILE_CELLS];
+            if (neighbour == -1)
+              continue;
+
+            float distanceX = fabsf(point.x - spawnPattern[neighbour].x);
+            float distanceY = fabsf(point.y - spawnPattern[neighbour].y);
+            distanceX = fminf(distanceX, SPAWN_TILE_SIZE - distanceX);
+            distanceY = fminf(distanceY, SPAWN_TILE_SIZE - distanceY);
+
+            if (distanceX * distanceX + distanceY * distanceY <
+                SPAWN_SPACING * SPAWN_SPACING)
+              found = false;
+          }
+        }
+      }
+
+      if (!found)
+        active[i] = active[--activeCount];
+    }
+
+    if (!found)
+      return;
+  }
+}
+
+int getGreatestCommonDivisor(int a, int b)
+{
+  while (b != 0)
+  {
+    int remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+
+  return a;
+}
+
+void initializeSpawnDirector(Game *game)
+{
+  pthread_once(&spawnPatternOnce, buildSpawnPattern);
+
+  game->spawner.pending = 0;
+  game->spawner.ticksLeft = 0;
+  game->spawner.cursor = gameRandom(game);
+}
+
+// Takes the next of pointCount spawn points on the walk. Fails if it is off
+// the map, near a player or under an enemy.
+bool getNextSpawnPoint(Game *game, int pointCount, int stride,
+                       Vector2 *position)
+{
+  SpawnDirector *spawner = &game->spawner;
+  int point = spawner->cursor % pointCount;
+  spawner->cursor = (point + stride) % pointCount;
+
+  // Far chunks aren't simulated, an enemy there would just stand still
+  int chunk = game->world.activeChunks[point / spawnPatternCount];
+  Vector2 origin = getChunkOrigin(&game->world, chunk);
+  *position = spawnPattern[point % spawnPatternCount];
+  position->x += origin.x;
+  position->y += origin.y;
+
+  float halfMap = game->mapSize / 2.0f;
+  if (position->x >= halfMap || position->y >= halfMap)
+    return false;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    if (getDistanceBetweenVectors(*position, game->players[i].position) <
+        SPAWN_PLAYER_CLEARANCE)
+      return false;
+  }
+
+  // The grid is from the last tick, dead enemies may still be filed in it.
+  // Points spawned this tick are a spacing apart already.
+  EntityArchetype *enemies = &game->enemies;
+  SpatialGrid *grid = &game->enemyGrid;
+  int minColumn, minRow, maxColumn, maxRow;
+  getGridCellRange(grid,
+                   (Rectangle){position->x - SPAWN_SPACING,
+                               position->y - SPAWN_SPACING, SPAWN_SPACING * 2,
+                               SPAWN_SPACING * 2},
+                   &minColumn, &minRow, &maxColumn, &maxRow);
+
+  for (int row = minRow; row <= maxRow; row++)
+  {
+    for (int column = minColumn; column <= maxColumn; column++)
+    {
+      int enemy = grid->heads[row * grid->columns + column];
+
+      for (; enemy != -1; enemy = grid->next[enemy])
+      {
+        if (isEntityAlive(enemies, enemy) &&
+            getDistanceBetweenVectors(*position, enemies->positions[enemy]) <
+                SPAWN_SPACING)
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Adds the entity only, returns -1 if there is no room. Callers keep
+// enemyCount.
+int addEnemy(Game *game, Vector2 position)
+{
+  EntityArchetype *enemies = &game->enemies;
+
+  int slot = addEntity(enemies);
+  if (slot == -1)
+    return -1;
+
+  enemies->sizes[slot] = (Vector2){ENEMY_SIZE, ENEMY_SIZE};
+  enemies->damages[slot] = 5;
+  enemies->speeds[slot] = 200 / game->targetFPS;
+  enemies->positions[slot] = position;
+  game->enemyTiers[slot] = getEnemyTier(game, position);
+  placeMinimapEntity(&game->minimap, MINIMAP_ENEMY, slot, position);
+
+  // Filed straight away, so the grid is whole between ticks
+  insertGridEntry(&game->enemyGrid, slot, position);
+
+  return slot;
+}
+
+// Takes an enemy out of the simulation without counting it as dead
+void removeEnemy(Game *game, int slot)
+{
+  removeMinimapEntity(&game->minimap, MINIMAP_ENEMY, slot);
+  removeGridEntry(&game->enemyGrid, slot);
+  removeEntity(&game->enemies, slot);
+}
+
+// Spawns up to n enemies right away, returns how many found room
+int addEnemies(Game *game, int n)
+{
+  int spawned = 0;
+  int pointCount = game->world.activeCount * spawnPatternCount;
+  if (pointCount == 0)
+    return 0;
+
+  // A stride coprime with the point count visits every point once per lap,
+  // and one near the golden ratio scatters consecutive points apart
+  int stride = (int)(pointCount * 0.618f) | 1;
+  while (getGreatestCommonDivisor(stride, pointCount) != 1)
+    stride++;
+
+  int attempts = n * SPAWN_ATTEMPTS;
+  if (attempts > pointCount)
+    attempts = pointCount;
+
+  lockTracedMutex(&game->enemyCountMutex, "enemy count");
+  while (spawned < n && attempts-- > 0)
+  {
+    Vector2 position;
+    if (!getNextSpawnPoint(game, pointCount, stride, &position))
+      continue;
+
+    if (addEnemy(game, position) == -1)
+      break;
+
+    game->enemyCount++;
+    spawned++;
+  }
+
+  pthread_mutex_unlock(&game->enemyCountMutex);
+
+  return spawned;
+}
+
+// Spends this tick's spawn budget on the waves that have started
+void spawnPendingEnemies(Game *game)
+{
+  SpawnDirector *spawner = &game->spawner;
+  if (spawner->pending == 0)
+    return;
+
+  if (spawner->ticksLeft < 1)
+    spawner->ticksLeft = 1;
+
+  int budget = (spawner->pending + spawner->ticksLeft - 1) / spawner->ticksLeft;
+  if (budget > game->maxSpawnsPerTick)
+    budget = game->maxSpawnsPerTick;
+
+  // Whatever found no room is tried again next tick
+  spawner->pending -= addEnemies(game, budget);
+  spawner->ticksLeft--;
+}
+
+// Chebyshev distance from the chunk to the closest player
+float getChunkPlayerDistance(Game *game, int index)
+{
+  Vector2 origin = getChunkOrigin(&game->world, index);
+  float size = game->world.chunkSize;
+  float closest = INFINITY;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Vector2 position = game->players[i].position;
+    float distanceX = fmaxf(fmaxf(origin.x - position.x, 0),
+                            position.x - (origin.x + size));
+    float distanceY = fmaxf(fmaxf(origin.y - position.y, 0),
+                            position.y - (origin.y + size));
+    closest = fminf(closest, fmaxf(distanceX, distanceY));
+  }
+
+  return closest;
+}
+
+// Scatters n solar cells over the part of the chunk inside the map, drawn
+// from the chunk's own random state so it doesn't matter when it loads
+void addChunkSolarCells(Game *game, int index, int n)
+{
+  WorldChunk *chunk = &game->world.chunks[index];
+  Vector2 origin = getChunkOrigin(&game->world, index);
+  int size = (int)game->world.chunkSize;
+  float halfMap = game->mapSize / 2.0f;
+
+  for (int i = 0; i < n; i++)
+  {
+    Vector2 position = {origin.x + rand_r(&chunk->randomState) % size,
+                        origin.y + rand_r(&chunk->randomState) % size};
+
+    if (position.x < halfMap && position.y < halfMap)
+      addSolarCell(game, position);
+  }
+}
+
+void loadWorldChunk(Game *game, int index)
+{
+  World *world = &game->world;
+  WorldChunk *chunk = &world->chunks[index];
+
+  if (chunk->state == WORLD_CHUNK_UNLOADED)
+  {
+    addChunkSolarCells(game, index, SOLAR_CELLS_PER_CHUNK);
+  }
+  else
+  {
+    for (int i = 0; i < chunk->cellCount; i++)
+    {
+      addSolarCell(game, getStoredPosition(world, index, i));
+    }
+
+    for (int i = 0; i < chunk->enemyCount; i++)
+    {
+      Vector2 position = getStoredPosition(world, index, chunk->cellCount + i);
+
+      // Nowhere to put it, so it's gone for good
+      if (addEnemy(game, position) == -1)
+      {
+        lockTracedMutex(&game->enemyCountMutex, "enemy count");
+        game->enemyCount--;
+        pthread_mutex_unlock(&game->enemyCountMutex);
+      }
+    }
+
+    freeChunkData(world, index);
+  }
+
+  chunk->state = WORLD_CHUNK_ACTIVE;
+  world->activeChunks[world->activeCount++] = index;
+}
+
+// Finds the live entities of archetype filed in grid inside the chunk, so
+// evicting a chunk only visits the grid cells under it. Only counts them
+// if slots is NULL.
+int findChunkEntities(Game *game, SpatialGrid *grid, EntityArchetype *archetype,
+                      int index, int *slots)
+{
+  World *world = &game->world;
+  Vector2 origin = getChunkOrigin(world, index);
+  int count = 0;
+
+  int minColumn, minRow, maxColumn, maxRow;
+  getGridCellRange(grid,
+                   (Rectangle){origin.x, origin.y, world->chunkSize,
+                               world->chunkSize},
+                   &minColumn, &minRow, &maxColumn, &maxRow);
+
+  for (int row = minRow; row <= maxRow; row++)
+  {
+    for (int column = minColumn; column <= maxColumn; column++)
+    {
+      int slot = grid->heads[row * grid->columns + column];
+
+      for (; slot != -1; slot = grid->next[slot])
+      {
+        if (!isEntityAlive(archetype, slot) ||
+            getChunkIndex(world, archetype->positions[slot]) != index)
+          continue;
+
+        if (slots != NULL)
+          slots[count] = slot;
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+// Packs the chunk's solar cells and enemies away and takes them out of the
+// simulation. They still count towards enemyCount.
+void evictWorldChunk(Game *game, int activeIndex)
+{
+  World *world = &game->world;
+  EntityArchetype *cells = &game->solarCells;
+  EntityArchetype *enemies = &game->enemies;
+  int index = world->activeChunks[activeIndex];
+
+  int cellCount =
+      findChunkEntities(game, &game->solarCellGrid, cells, index, NULL);
+  int enemyCount =
+      findChunkEntities(game, &game->enemyGrid, enemies, index, NULL);
+  int count = cellCount + enemyCount;
+
+  Vector2 *positions = trackedMalloc(MEMORY_ENTITIES, count * sizeof(Vector2));
+  int *slots = trackedMalloc(MEMORY_ENTITIES, count * sizeof(int));
+
+  // Gathered before removing, removing unlinks them from the grid
+  findChunkEntities(game, &game->solarCellGrid, cells, index, slots);
+  findChunkEntities(game, &game->enemyGrid, enemies, index, slots + cellCount);
+
+  for (int i = 0; i < cellCount; i++)
+  {
+    positions[i] = cells->positions[slots[i]];
+    removeSolarCell(game, slots[i]);
+  }
+
+  for (int i = cellCount; i < count; i++)
+  {
+    positions[i] = enemies->positions[slots[i]];
+    removeEnemy(game, slots[i]);
+  }
+
+  storeChunkData(world, index, positions, cellCount, enemyCount);
+  trackedFree(positions);
+  trackedFree(slots);
+
+  world->chunks[index].state = WORLD_CHUNK_EVICTED;
+  world->activeChunks[activeIndex] = world->activeChunks[--world->activeCount];
+}
+
+// Loads the chunks players have come close to and evicts those they have
+// left behind. Only touches chunks near players or already active.
+void updateWorldChunks(Game *game)
+{
+  World *world = &game->world;
+
+  for (int i = world->activeCount - 1; i >= 0; i--)
+  {
+    if (getChunkPlayerDistance(game, world->activeChunks[i]) >
+        WORLD_EVICT_RANGE)
+      evictWorldChunk(game, i);
+  }
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Vector2 position = game->players[i].position;
+    int minColumn = getChunkColumn(world, position.x - WORLD_ACTIVE_RANGE);
+    int maxColumn = getChunkColumn(world, position.x + WORLD_ACTIVE_RANGE);
+    int minRow = getChunkRow(world, position.y - WORLD_ACTIVE_RANGE);
+    int maxRow = getChunkRow(world, position.y + WORLD_ACTIVE_RANGE);
+
+    for (int row = minRow; row <= maxRow; row++)
+    {
+      for (int column = minColumn; column <= maxColumn; column++)
+      {
+        int index = row * world->columns + column;
+        if (world->chunks[index].state != WORLD_CHUNK_ACTIVE &&
+            getChunkPlayerDistance(game, index) <= WORLD_ACTIVE_RANGE)
+          loadWorldChunk(game, index);
+      }
+    }
+  }
+}
+
+// Tops up every chunk near the players with new solar cells
+void generateSolarCells(Game *game)
+{
+  for (int i = 0; i < game->world.activeCount; i++)
+  {
+    addChunkSolarCells(game, game->world.activeChunks[i],
+                       SOLAR_CELLS_PER_CHUNK);
+  }
+}
+
+void killEnemy(Game *game, int enemyIndex)
+{
+  removeEnemy(game, enemyIndex);
+  lockTracedMutex(&game->enemyCountMutex, "enemy count");
+  game->enemyCount--;
+  game->enemiesKilled++;
+  pthread_mutex_unlock(&game->enemyCountMutex);
+}
+
+// Launches a bolt from position, returns false if the pool is full
+bool fireProjectile(Game *game, int owner, Vector2 position, Vector2 direction)
+{
+  EntityArchetype *projectiles = &game->projectiles;
+
+  int slot = addEntity(projectiles);
+  if (slot == -1)
+    return false;
+
+  float speed = (float)PROJECTILE_SPEED / game->targetFPS;
+
+  projectiles->positions[slot] = position;
+  projectiles->sizes[slot] = (Vector2){PROJECTILE_SIZE, PROJECTILE_SIZE};
+  projectiles->velocities[slot] =
+      (Vector2){direction.x * speed, direction.y * speed};
+  projectiles->lifetimes[slot] = (int)ceilf(game->gunRange / speed);
+  projectiles->owners[slot] = owner;
+
+  return true;
+}
+
+void handleShoot(Game *game, Player *player)
+{
+  float shotCost = 0.1;
+  int playerIndex = player - game->players;
+
+  lockTracedMutex(&player->mutex, "player");
+  Vector2 position = player->position;
+  Vector2 direction = {player->flipDir, 0};
+  pthread_mutex_unlock(&player->mutex);
+
+  if (game->battery <= shotCost)
+  {
+    emitGameEvent(game, GAME_EVENT_OUT_OF_AMMO, playerIndex, -1, position);
+    return;
+  }
+
+  // Aim at the closest enemy in range, otherwise straight ahead
+  int closestEnemy = getClosestEnemyIndex(game, position, game->gunRange);
+
+  if (closestEnemy != -1)
+  {
+    direction = getDirectionVector2s(position,
+                                     game->enemies.positions[closestEnemy]);
+  }
+
+  if (!fireProjectile(game, playerIndex, position, direction))
+    return;
+
+  lockTracedMutex(&game->batteryMutex, "battery");
+  game->battery -= shotCost;
+  pthread_mutex_unlock(&game->batteryMutex);
+
+  emitGameEvent(game, GAME_EVENT_SHOT_FIRED, playerIndex, -1, position);
+}
+
+// Files every live enemy under the grid cell it stands in
+void indexEnemies(Game *game)
+{
+  EntityArchetype *enemies = &game->enemies;
+
+  clearSpatialGrid(&game->enemyGrid);
+
+  for (int i = 0; i < enemies->liveCount; i++)
+  {
+    int slot = enemies->live[i];
+    insertGridEntry(&game->enemyGrid, slot, enemies->positions[slot]);
+  }
+}
+
+// Moves the live projectiles [start, end) and records the first enemy each
+// one swept through. Only touches those projectiles, so ranges can run side
+// by side once the enemies are indexed.
+void updateProjectileRange(Game *game, int start, int end)
+{
+  EntityArchetype *projectiles = &game->projectiles;
+  EntityArchetype *enemies = &game->enemies;
+  SpatialGrid *grid = &game->enemyGrid;
+
+  // Enemies are filed by their centre, so look this far around a sweep
+  float reach = (ENEMY_SIZE + PROJECTILE_SIZE) / 2.0f;
+
+  if (end > projectiles->liveCount)
+    end = projectiles->liveCount;
+
+  for (int k = start; k < end; k++)
+  {
+    int slot = projectiles->live[k];
+    Vector2 from = projectiles->positions[slot];
+    Vector2 velocity = projectiles->velocities[slot];
+    Vector2 to = {from.x + velocity.x, from.y + velocity.y};
+
+    projectiles->positions[slot] = to;
+    projectiles->lifetimes[slot]--;
+    game->projectileHits[k] = -1;
+
+    int minColumn, minRow, maxColumn, maxRow;
+    getGridCellRange(grid,
+                     (Rectangle){fminf(from.x, to.x) - reach,
+                                 fminf(from.y, to.y) - reach,
+                                 fabsf(velocity.x) + reach * 2,
+                                 fabsf(velocity.y) + reach * 2},
+                     &minColumn, &minRow, &maxColumn, &maxRow);
+
+    float closestHit = 2;
+
+    for (int row = minRow; row <= maxRow; row++)
+    {
+      for (int column = minColumn; column <= maxColumn; column++)
+      {
+        int enemy = grid->heads[row * grid->columns + column];
+
+        for (; enemy != -1; enemy = grid->next[enemy])
+        {
+          float hit = getSegmentCircleHit(
+              from, to, enemies->positions[enemy],
+              (enemies->sizes[enemy].x + PROJECTILE_SIZE) / 2);
+
+          if (hit >= 0 && hit < closestHit)
+          {
+            closestHit = hit;
+            game->projectileHits[k] = enemy;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Kills what the projectiles hit and retires spent ones, in live order so
+// the outcome doesn't depend on how the update was split up
+void resolveProjectileHits(Game *game)
+{
+  EntityArchetype *projectiles = &game->projectiles;
+
+  for (int k = projectiles->liveCount - 1; k >= 0; k--)
+  {
+    int slot = projectiles->live[k];
+    int enemy = game->projectileHits[k];
+
+    // Another bolt may have got there first, then this one flies on
+    if (enemy != -1 && isEntityAlive(&game->enemies, enemy))
+    {
+      Vector2 enemyPosition = game->enemies.positions[enemy];
+      killEnemy(game, enemy);
+      emitGameEvent(game, GAME_EVENT_ENEMY_KILLED, projectiles->owners[slot],
+                    enemy, enemyPosition);
+
+      removeEntity(projectiles, slot);
+    }
+    else if (projectiles->lifetimes[slot] <= 0)
+    {
+      removeEntity(projectiles, slot);
+    }
+  }
+}
+
+void updateProjectiles(Game *game)
+{
+  updateProjectileRange(game, 0, game->projectiles.liveCount);
+  resolveProjectileHits(game);
+}
+
+// Only touches the player itself, so players can move in parallel
+void movePlayer(Game *game, Player *player, PlayerInput input)
+{
+  Vector2 direction = {0, 0};
+
+  if (input.held & INPUT_UP)
+    direction.y = -1; // Up
+  if (input.held & INPUT_LEFT)
+  {
+    direction.x = -1; // Left
+    player->flipDir = -1;
+  }
+  if (input.held & INPUT_DOWN)
+    direction.y = 1; // Down
+  if (input.held & INPUT_RIGHT)
+  {
+    direction.x = 1; // Right
+    player->flipDir = 1;
+  }
+
+  // Apply movement if game isn't paused
+  if (!game->paused && (direction.x != 0 || direction.y != 0))
+  {
+    direction = normalizeVector2(direction);
+
+    Vector2 velocity = {direction.x * player->speed,
+                        direction.y * player->speed};
+
+    int boundx = game->mapSize / 2, boundy = game->mapSize / 2;
+
+    if (velocity.x < 0 && player->position.x < -boundx)
+    {
+      velocity.x = 0;
+    }
+
+    if (velocity.x > 0 && player->position.x > boundx)
+    {
+      velocity.x = 0;
+    }
+
+    if (velocity.y < 0 && player->position.y < -boundy)
+    {
+      velocity.y = 0;
+    }
+
+    if (velocity.y > 0 && player->position.y > boundy)
+    {
+      velocity.y = 0;
+    }
+
+    velocity =
+        slideAgainstChargers(game, player->position, player->size, velocity);
+
+    lockTracedMutex(&player->mutex, "player");
+    player->position.x += velocity.x;
+    player->position.y += velocity.y;
+
+    pthread_mutex_unlock(&player->mutex);
+  }
+}
+
+// Building, shooting and pickups, which change shared state
+void applyPlayerActions(Game *game, Player *player, PlayerInput input)
+{
+  // Build Solar Charger Small
+  if (input.pressed & INPUT_BUILD_SMALL)
+  {
+    lockTracedMutex(&player->mutex, "player");
+
+    buildSolarCharger(game, player->position, 1);
+
+    pthread_mutex_unlock(&player->mutex);
+  }
+
+  // Build Solar Charger Large
+  if (input.pressed & INPUT_BUILD_LARGE)
+  {
+    lockTracedMutex(&player->mutex, "player");
+
+    buildSolarCharger(game, player->position, 2);
+
+    pthread_mutex_unlock(&player->mutex);
+  }
+
+  // Shoot action
+  if (input.pressed & INPUT_SHOOT)
+  {
+
+    handleShoot(game, player);
+  }
+
+  // Check if solar cell collected
+  collectSolarCells(game, player);
+}
+
+void win(Game *game)
+{
+  game->paused = true;
+  game->gameWon = true;
+}
+
+void handleGameOver(Game *game)
+{
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    if (game->players[i].health < 0)
+    {
+      game->paused = true;
+      game->gameOver = true;
+    }
+  }
+}
+
+void generateEnemies(Game *game)
+{
+  if (game->currentWave < game->numWaves)
+  {
+    if (game->frameCount >
+        game->lastWaveFrame +
+            game->waves[game->currentWave].waitTime * game->targetFPS)
+    {
+
+      // Unleash the enemies for this wave
+      emitGameEvent(game, GAME_EVENT_WAVE_STARTED, -1, game->currentWave,
+                    (Vector2){0, 0});
+
+      game->spawner.pending += game->waves[game->currentWave].numEnemies;
+      game->spawner.ticksLeft = game->waveSpawnTicks;
+      game->lastWaveFrame = game->frameCount;
+      game->currentWave++;
+    }
+  }
+  else
+  {
+    if (game->enemyCount <= 0 && game->spawner.pending == 0)
+      win(game);
+  }
+
+  spawnPendingEnemies(game);
+}
+
+void restartGame(Game *game)
+{
+  game->paused = false;
+  game->currentWave = 0;
+  game->lastWaveFrame = game->frameCount;
+  game->battery = 0;
+  game->solarCellsCollected = 0;
+  game->enemyCount = 0;
+  game->spawner.pending = 0;
+  game->gameOver = false;
+  game->gameWon = false;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    game->players[i].health = 100;
+    game->players[i].position =
+        (Vector2){0 + i * (20 + game->players[i].size), 0};
+  }
+  clearEntities(&game->enemies);
+  clearEntities(&game->projectiles);
+  clearEntities(&game->solarChargers);
+  clearEntities(&game->solarCells);
+  clearSpatialGrid(&game->enemyGrid);
+  clearSpatialGrid(&game->solarCellGrid);
+  clearMinimap(&game->minimap);
+  clearObstacleTree(&game->chargerTree);
+
+  // The same seed, so the world comes back as it started
+  resetWorld(&game->world);
+  updateWorldChunks(game);
+}
+
+
+// Settings every game starts from before command line overrides
+void setDefaultGameSettings(Game *game)
+{
+  game->targetFPS = 60;
+  game->playerCount = 2;
+
+  game->messageDuration = 1;
+
+  game->gunRange = 300;
+  game->maxEnemies = 300;
+  game->maxSolarCells = 100;
+  game->maxSolarChargers = 300;
+  game->maxProjectiles = 4096;
+
+  game->waveSpawnTicks = 60;
+  game->maxSpawnsPerTick = 16;
+
+  game->mapSize = 2000;
+
+  // A 1080p view at the default zoom, until the viewports or clients say
+  game->viewHalfExtent = (Vector2){960, 540};
+}
+
+// Sets up everything the simulation needs, but nothing tied to a window
+void initializeSimulation(Game *game)
+{
+  if (game->headless)
+    game->sound = &silentSound;
+
+  pthread_mutex_init(&game->enemyCountMutex, NULL);
+  pthread_mutex_init(&game->batteryMutex, NULL);
+  pthread_mutex_init(&game->solarCellsMutex, NULL);
+
+  initializeWaves(game);
+  initializePlayers(game);
+  initializeWorld(&game->world,
+                  (Vector2){-game->mapSize / 2.0f, -game->mapSize / 2.0f},
+                  game->mapSize, WORLD_CHUNK_SIZE, gameRandom(game));
+  initializeEnemies(game);
+  initializeSpawnDirector(game);
+  initializeProjectiles(game);
+  initializeSolarChargers(game);
+  initializeSolarCells(game);
+
+  int capacities[MINIMAP_KIND_COUNT] = {
+      game->maxEnemies, game->maxSolarCells, game->maxSolarChargers};
+  initializeMinimap(&game->minimap,
+                    (Vector2){-game->mapSize / 2.0f, -game->mapSize / 2.0f},
+                    game->mapSize, capacities);
+}
+
+// Frees everything initializeSimulation made, if it ran
+void destroySimulation(Game *game)
+{
+  if (game->players == NULL)
+    return;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    pthread_mutex_destroy(&game->players[i].mutex);
+  }
+  pthread_mutex_destroy(&game->enemyCountMutex);
+  pthread_mutex_destroy(&game->batteryMutex);
+  pthread_mutex_destroy(&game->solarCellsMutex);
+
+  trackedFree(game->players);
+  game->players = NULL;
+
+  destroyArchetype(&game->enemies);
+  destroySpatialGrid(&game->enemyGrid);
+  trackedFree(game->enemyPositions);
+  trackedFree(game->enemyTiers);
+  destroyArchetype(&game->projectiles);
+  trackedFree(game->projectileHits);
+  destroyArchetype(&game->solarCells);
+  destroySpatialGrid(&game->solarCellGrid);
+  destroyArchetype(&game->solarChargers);
+  destroyObstacleTree(&game->chargerTree);
+  destroyMinimap(&game->minimap);
+  destroyWorld(&game->world);
+}
+
+// Advances the world by one frame from game->playerInputs, one step after
+// another in the same order as the job graph in main.c: players move, then
+// enemies, then players act, then projectiles and energy
+void stepGame(Game *game)
+{
+  handleGameOver(game);
+
+  if (game->paused)
+    return;
+
+  if (game->frameCount % WORLD_UPDATE_TICKS == 0)
+  {
+    updateWorldChunks(game);
+  }
+
+  if (game->frameCount % (game->targetFPS * 5) == 0)
+  {
+    generateSolarCells(game);
+  }
+
+  generateEnemies(game);
+
+  updateMessage(game);
+  updateEnemyTiers(game);
+  snapshotEnemyPositions(game);
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    movePlayer(game, &game->players[i], game->playerInputs[i]);
+  }
+
+  updateEnemyRange(game, 0, game->enemies.liveCount);
+  indexEnemies(game);
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    applyPlayerActions(game, &game->players[i], game->playerInputs[i]);
+  }
+
+  updateProjectiles(game);
+
+  chargeBattery(game, 0, game->maxSolarChargers);
+
+  game->frameCount++;
+}
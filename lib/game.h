@@ -0,0 +1,123 @@
+#include "game.c"
+
+int gameRandom(Game *game);
+
+void playMultiSound(MultiSound *multiSound);
+
+void updateMessage(Game *game);
+
+void showMessage(Game *game, char message[], int fontSize);
+
+void chargeBattery(Game *game, int start, int end);
+
+void initializeSolarChargers(Game *game);
+
+Rectangle getChargerBox(Game *game, int slot);
+
+void rebuildChargerTree(Game *game);
+
+Vector2 slideAgainstChargers(Game *game, Vector2 position, float size,
+                             Vector2 velocity);
+
+void buildSolarCharger(Game *game, Vector2 position, int size);
+
+void initializePlayers(Game *game);
+
+int getClosestEnemyIndex(Game *game, Vector2 from, float range);
+
+void initializeEnemies(Game *game);
+
+void initializeProjectiles(Game *game);
+
+void initializeWaves(Game *game);
+
+void initializeSolarCells(Game *game);
+
+void addSolarCell(Game *game, Vector2 position);
+
+void removeSolarCell(Game *game, int cellIndex);
+
+void collectSolarCells(Game *game, Player *player);
+
+void snapshotEnemyPositions(Game *game);
+
+Player *getClosestPlayer(Game *game, Vector2 position, float *distance);
+
+float getEnemyNearRange(Game *game);
+
+int getEnemyTier(Game *game, Vector2 position);
+
+void updateEnemyTiers(Game *game);
+
+bool separateEnemy(Game *game, int slot, Vector2 *position, float radius,
+                   float step);
+
+void updateEnemyRange(Game *game, int start, int end);
+
+float getSpawnRandom(unsigned int *seed);
+
+void buildSpawnPattern(void);
+
+int getGreatestCommonDivisor(int a, int b);
+
+void initializeSpawnDirector(Game *game);
+
+bool getNextSpawnPoint(Game *game, int pointCount, int stride,
+                       Vector2 *position);
+
+int addEnemy(Game *game, Vector2 position);
+
+void removeEnemy(Game *game, int slot);
+
+int addEnemies(Game *game, int n);
+
+void spawnPendingEnemies(Game *game);
+
+float getChunkPlayerDistance(Game *game, int index);
+
+void addChunkSolarCells(Game *game, int index, int n);
+
+void loadWorldChunk(Game *game, int index);
+
+int findChunkEntities(Game *game, SpatialGrid *grid, EntityArchetype *archetype,
+                      int index, int *slots);
+
+void evictWorldChunk(Game *game, int activeIndex);
+
+void updateWorldChunks(Game *game);
+
+void generateSolarCells(Game *game);
+
+void killEnemy(Game *game, int enemyIndex);
+
+bool fireProjectile(Game *game, int owner, Vector2 position, Vector2 direction);
+
+void handleShoot(Game *game, Player *player);
+
+void indexEnemies(Game *game);
+
+void updateProjectileRange(Game *game, int start, int end);
+
+void resolveProjectileHits(Game *game);
+
+void updateProjectiles(Game *game);
+
+void movePlayer(Game *game, Player *player, PlayerInput input);
+
+void applyPlayerActions(Game *game, Player *player, PlayerInput input);
+
+void win(Game *game);
+
+void handleGameOver(Game *game);
+
+void generateEnemies(Game *game);
+
+void restartGame(Game *game);
+
+void setDefaultGameSettings(Game *game);
+
+void initializeSimulation(Game *game);
+
+void destroySimulation(Game *game);
+
+void stepGame(Game *game);
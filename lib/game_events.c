@@ -0,0 +1,90 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+
+GameEventQueue *createGameEventQueue(void)
+{
+  GameEventQueue *queue =
+      trackedCalloc(MEMORY_THREADING, 1, sizeof(GameEventQueue));
+
+  // A slot is free for position p when its sequence is p, and holds the
+  // event written at p once it is p + 1
+  for (unsigned int i = 0; i < GAME_EVENT_QUEUE_SIZE; i++)
+  {
+    atomic_init(&queue->slots[i].sequence, i);
+  }
+
+  return queue;
+}
+
+// Safe to call from any thread. Returns false and drops the event if the
+// consumer has fallen a full queue behind.
+bool pushGameEvent(GameEventQueue *queue, GameEvent event)
+{
+  unsigned int position =
+      atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+  while (true)
+  {
+    GameEventSlot *slot = &queue->slots[position % GAME_EVENT_QUEUE_SIZE];
+    unsigned int sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    int difference = (int)(sequence - position);
+
+    if (difference == 0)
+    {
+      // Claim the slot, on failure position is reloaded and we retry
+      if (atomic_compare_exchange_weak_explicit(&queue->head, &position,
+                                                position + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+      {
+        slot->event = event;
+        atomic_store_explicit(&slot->sequence, position + 1,
+                              memory_order_release);
+        return true;
+      }
+    }
+    else if (difference < 0)
+    {
+      atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      // Another producer took this slot first
+      position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    }
+  }
+}
+
+// Only to be called from the consuming thread
+bool popGameEvent(GameEventQueue *queue, GameEvent *event)
+{
+  GameEventSlot *slot = &queue->slots[queue->tail % GAME_EVENT_QUEUE_SIZE];
+  unsigned int sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+  if (sequence != queue->tail + 1)
+    return false;
+
+  *event = slot->event;
+  atomic_store_explicit(&slot->sequence, queue->tail + GAME_EVENT_QUEUE_SIZE,
+                        memory_order_release);
+  queue->tail++;
+
+  return true;
+}
+
+void emitGameEvent(Game *game, GameEventType type, int player, int index,
+                   Vector2 position)
+{
+  if (game->events == NULL)
+    return;
+
+  pushGameEvent(game->events, (GameEvent){type, player, index, position});
+}
+
+void destroyGameEventQueue(GameEventQueue *queue)
+{
+  trackedFree(queue);
+}
@@ -0,0 +1,12 @@
+#include "game_events.c"
+
+GameEventQueue *createGameEventQueue(void);
+
+bool pushGameEvent(GameEventQueue *queue, GameEvent event);
+
+bool popGameEvent(GameEventQueue *queue, GameEvent *event);
+
+void emitGameEvent(Game *game, GameEventType type, int player, int index,
+                   Vector2 position);
+
+void destroyGameEventQueue(GameEventQueue *queue);
@@ -0,0 +1,301 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Which queue the current thread owns, threads outside the system use 0
+_Thread_local int jobQueueIndex = 0;
+
+bool pushJobTask(JobQueue *queue, JobTask task)
+{
+  lockTracedMutex(&queue->mutex, "job queue");
+  bool pushed = queue->bottom - queue->top < JOB_QUEUE_SIZE;
+  if (pushed)
+    queue->tasks[queue->bottom++ % JOB_QUEUE_SIZE] = task;
+  pthread_mutex_unlock(&queue->mutex);
+
+  return pushed;
+}
+
+// Newest first, so a thread keeps working on what it just made ready
+bool popJobTask(JobQueue *queue, JobTask *task)
+{
+  lockTracedMutex(&queue->mutex, "job queue");
+  bool popped = queue->bottom > queue->top;
+  if (popped)
+    *task = queue->tasks[--queue->bottom % JOB_QUEUE_SIZE];
+  pthread_mutex_unlock(&queue->mutex);
+
+  return popped;
+}
+
+// Oldest first, which tends to be the biggest remaining piece of work
+bool stealJobTask(JobQueue *queue, JobTask *task)
+{
+  lockTracedMutex(&queue->mutex, "job queue");
+  bool stolen = queue->bottom > queue->top;
+  if (stolen)
+    *task = queue->tasks[queue->top++ % JOB_QUEUE_SIZE];
+  pthread_mutex_unlock(&queue->mutex);
+
+  return stolen;
+}
+
+void wakeJobThreads(JobSystem *system)
+{
+  lockTracedMutex(&system->mutex, "job system");
+  pthread_cond_broadcast(&system->wake);
+  pthread_mutex_unlock(&system->mutex);
+}
+
+void runJobTask(JobSystem *system, JobTask task);
+
+// Queues every part of a job whose prerequisites are all done
+void scheduleJob(JobSystem *system, Job *job)
+{
+  JobQueue *queue = &system->queues[jobQueueIndex];
+
+  for (int i = 0; i < job->partCount; i++)
+  {
+    JobTask task = {job, i};
+
+    if (pushJobTask(queue, task))
+    {
+      atomic_fetch_add(&system->queuedTasks, 1);
+    }
+    else
+    {
+      // Queue is full, let the others at it while this thread helps out
+      wakeJobThreads(system);
+      runJobTask(system, task);
+    }
+  }
+
+  wakeJobThreads(system);
+}
+
+void runJobTask(JobSystem *system, JobTask task)
+{
+  Job *job = task.job;
+  if (job->function != NULL)
+  {
+    beginTraceSpan(job->name);
+    job->function(job->data, task.index);
+    endTraceSpan();
+  }
+
+  if (atomic_fetch_sub(&job->unfinishedParts, 1) != 1)
+    return;
+
+  // Last part done, release whatever was waiting on this job
+  for (int i = 0; i < job->dependentCount; i++)
+  {
+    Job *dependent = job->dependents[i];
+    if (atomic_fetch_sub(&dependent->dependencies, 1) == 1)
+      scheduleJob(system, dependent);
+  }
+
+  if (atomic_fetch_sub(&system->pendingJobs, 1) == 1)
+    wakeJobThreads(system);
+}
+
+// Takes a task from this thread's queue, or steals one from another
+bool findJobTask(JobSystem *system, JobTask *task)
+{
+  if (popJobTask(&system->queues[jobQueueIndex], task))
+  {
+    atomic_fetch_sub(&system->queuedTasks, 1);
+    return true;
+  }
+
+  for (int i = 1; i < system->queueCount; i++)
+  {
+    int victim = (jobQueueIndex + i) % system->queueCount;
+    if (stealJobTask(&system->queues[victim], task))
+    {
+      atomic_fetch_sub(&system->queuedTasks, 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void *runJobWorker(void *arg)
+{
+  JobSystem *system = ((JobWorkerArgument *)arg)->system;
+  jobQueueIndex = ((JobWorkerArgument *)arg)->queueIndex;
+  trackedFree(arg);
+
+  char name[32];
+  snprintf(name, sizeof(name), "job worker %d", jobQueueIndex);
+  setTraceThreadName(name);
+
+  JobTask task;
+
+  while (true)
+  {
+    if (findJobTask(system, &task))
+    {
+      runJobTask(system, task);
+      continue;
+    }
+
+    // Sleep until there is something to take instead of spinning
+    lockTracedMutex(&system->mutex, "job system");
+    while (atomic_load(&system->queuedTasks) == 0 && !system->stopping)
+      waitTracedCondition(&system->wake, &system->mutex, "idle");
+    bool stopping = system->stopping;
+    pthread_mutex_unlock(&system->mutex);
+
+    if (stopping)
+      return NULL;
+  }
+}
+
+// workerCount < 0 sizes the pool to the hardware, leaving one core for the
+// thread that submits jobs, which also works through them while it waits
+JobSystem *createJobSystem(int workerCount)
+{
+  if (workerCount < 0)
+    workerCount = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  if (workerCount < 0)
+    workerCount = 0;
+
+  JobSystem *system =
+      trackedAlignedCalloc(MEMORY_THREADING, 1, sizeof(JobSystem));
+  system->workerCount = workerCount;
+  system->queueCount = workerCount + 1;
+  system->queues = trackedAlignedCalloc(MEMORY_THREADING, system->queueCount,
+                                        sizeof(JobQueue));
+  system->workers =
+      trackedCalloc(MEMORY_THREADING, workerCount, sizeof(pthread_t));
+
+  for (int i = 0; i < system->queueCount; i++)
+  {
+    pthread_mutex_init(&system->queues[i].mutex, NULL);
+  }
+
+  pthread_mutex_init(&system->mutex, NULL);
+  pthread_cond_init(&system->wake, NULL);
+
+  for (int i = 0; i < workerCount; i++)
+  {
+    JobWorkerArgument *arg =
+        trackedMalloc(MEMORY_THREADING, sizeof(JobWorkerArgument));
+    arg->system = system;
+    arg->queueIndex = i + 1;
+
+    pthread_create(&system->workers[i], NULL, runJobWorker, (void *)arg);
+  }
+
+  return system;
+}
+
+// Adds a job with partCount parts to the current frame's graph. Wire up its
+// dependencies before submitting anything it depends on. name labels its
+// parts in traces.
+Job *createJob(JobSystem *system, const char *name, JobFunction function,
+               void *data, int partCount)
+{
+  if (system->jobCount == MAX_FRAME_JOBS)
+  {
+    printf("ERROR: Too many jobs in one frame\n");
+    exit(1);
+  }
+
+  // An empty job still runs once so its dependents get released
+  if (partCount < 1)
+  {
+    function = NULL;
+    partCount = 1;
+  }
+
+  Job *job = &system->jobs[system->jobCount++];
+  job->name = name;
+  job->function = function;
+  job->data = data;
+  job->partCount = partCount;
+  job->dependentCount = 0;
+  atomic_store(&job->unfinishedParts, partCount);
+  atomic_store(&job->dependencies, 1);
+  atomic_fetch_add(&system->pendingJobs, 1);
+
+  return job;
+}
+
+// job will not start until dependency has finished
+void addJobDependency(Job *job, Job *dependency)
+{
+  if (dependency->dependentCount == MAX_JOB_DEPENDENTS)
+  {
+    printf("ERROR: Too many jobs depend on one job\n");
+    exit(1);
+  }
+
+  dependency->dependents[dependency->dependentCount++] = job;
+  atomic_fetch_add(&job->dependencies, 1);
+}
+
+void submitJob(JobSystem *system, Job *job)
+{
+  if (atomic_fetch_sub(&job->dependencies, 1) == 1)
+    scheduleJob(system, job);
+}
+
+// Helps run the frame's jobs until every one has finished, then frees them
+void waitForJobs(JobSystem *system)
+{
+  JobTask task;
+
+  while (atomic_load(&system->pendingJobs) > 0)
+  {
+    if (findJobTask(system, &task))
+    {
+      runJobTask(system, task);
+      continue;
+    }
+
+    lockTracedMutex(&system->mutex, "job system");
+    while (atomic_load(&system->queuedTasks) == 0 &&
+           atomic_load(&system->pendingJobs) > 0)
+      waitTracedCondition(&system->wake, &system->mutex, "wait for jobs");
+    pthread_mutex_unlock(&system->mutex);
+  }
+
+  system->jobCount = 0;
+}
+
+// Shorthand for a graph of one job
+void runJob(JobSystem *system, const char *name, JobFunction function,
+            void *data, int partCount)
+{
+  submitJob(system, createJob(system, name, function, data, partCount));
+  waitForJobs(system);
+}
+
+void destroyJobSystem(JobSystem *system)
+{
+  pthread_mutex_lock(&system->mutex);
+  system->stopping = true;
+  pthread_cond_broadcast(&system->wake);
+  pthread_mutex_unlock(&system->mutex);
+
+  for (int i = 0; i < system->workerCount; i++)
+  {
+    pthread_join(system->workers[i], NULL);
+  }
+
+  for (int i = 0; i < system->queueCount; i++)
+  {
+    pthread_mutex_destroy(&system->queues[i].mutex);
+  }
+
+  pthread_mutex_destroy(&system->mutex);
+  pthread_cond_destroy(&system->wake);
+
+  trackedFree(system->queues);
+  trackedFree(system->workers);
+  trackedFree(system);
+}
@@ -0,0 +1,17 @@
+#include "job_system.c"
+
+JobSystem *createJobSystem(int workerCount);
+
+Job *createJob(JobSystem *system, const char *name, JobFunction function,
+               void *data, int partCount);
+
+void addJobDependency(Job *job, Job *dependency);
+
+void submitJob(JobSystem *system, Job *job);
+
+void waitForJobs(JobSystem *system);
+
+void runJob(JobSystem *system, const char *name, JobFunction function,
+            void *data, int partCount);
+
+void destroyJobSystem(JobSystem *system);
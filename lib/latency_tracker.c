@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Input is latched this long before the predicted present, to absorb jitter
+#define LATENCY_LATCH_MARGIN 0.002f
+// How quickly the latch work estimate falls after a slow frame
+#define LATENCY_WORK_DECAY 0.02f
+
+void initLatencyTracker(LatencyTracker *tracker)
+{
+  tracker->sampleCount = 0;
+  tracker->nextSample = 0;
+  tracker->p50 = 0;
+  tracker->p95 = 0;
+  tracker->p99 = 0;
+  tracker->pollTime = 0;
+  tracker->presentedInputTime = 0;
+  tracker->latchWorkTime = 0;
+}
+
+int compareLatencies(const void *a, const void *b)
+{
+  float difference = *(const float *)a - *(const float *)b;
+  return (difference > 0) - (difference < 0);
+}
+
+void updateLatencyPercentiles(LatencyTracker *tracker)
+{
+  float sorted[LATENCY_SAMPLES];
+  int count = tracker->sampleCount;
+
+  for (int i = 0; i < count; i++)
+  {
+    sorted[i] = tracker->samples[i];
+  }
+  qsort(sorted, count, sizeof(float), compareLatencies);
+
+  // Nearest rank
+  tracker->p50 = sorted[(count * 50 + 99) / 100 - 1];
+  tracker->p95 = sorted[(count * 95 + 99) / 100 - 1];
+  tracker->p99 = sorted[(count * 99 + 99) / 100 - 1];
+}
+
+// Called once a frame is on screen with the time its input was polled.
+// Frames showing the same input again, like while paused, are only counted
+// the first time.
+void recordFrameLatency(LatencyTracker *tracker, double inputTime,
+                        double presentTime)
+{
+  if (inputTime <= tracker->presentedInputTime)
+    return;
+  tracker->presentedInputTime = inputTime;
+
+  tracker->samples[tracker->nextSample] = presentTime - inputTime;
+  tracker->nextSample = (tracker->nextSample + 1) % LATENCY_SAMPLES;
+  if (tracker->sampleCount < LATENCY_SAMPLES)
+    tracker->sampleCount++;
+
+  updateLatencyPercentiles(tracker);
+}
+
+// Seconds from latching input to the frame being presented. Rises straight
+// away so a slow frame doesn't miss vsync twice, and falls slowly.
+void recordLatchWorkTime(LatencyTracker *tracker, float seconds)
+{
+  if (seconds > tracker->latchWorkTime)
+    tracker->latchWorkTime = seconds;
+  else
+    tracker->latchWorkTime +=
+        (seconds - tracker->latchWorkTime) * LATENCY_WORK_DECAY;
+}
+
+// When to poll input so the frame is done just before the next present
+double getLatchTime(LatencyTracker *tracker, double lastPresentTime,
+                    float framePeriod)
+{
+  return lastPresentTime + framePeriod - tracker->latchWorkTime -
+         LATENCY_LATCH_MARGIN;
+}
+
+void printLatencyReport(LatencyTracker *tracker)
+{
+  if (tracker->sampleCount == 0)
+    return;
+
+  printf("Input to present latency over the last %d frames: p50 %.1fms "
+         "p95 %.1fms p99 %.1fms (%s)\n",
+         tracker->sampleCount, tracker->p50 * 1000, tracker->p95 * 1000,
+         tracker->p99 * 1000,
+         tracker->lowLatency ? "low latency" : "pipelined");
+}
@@ -0,0 +1,13 @@
+#include "latency_tracker.c"
+
+void initLatencyTracker(LatencyTracker *tracker);
+
+void recordFrameLatency(LatencyTracker *tracker, double inputTime,
+                        double presentTime);
+
+void recordLatchWorkTime(LatencyTracker *tracker, float seconds);
+
+double getLatchTime(LatencyTracker *tracker, double lastPresentTime,
+                    float framePeriod);
+
+void printLatencyReport(LatencyTracker *tracker);
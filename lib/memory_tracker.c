@@ -0,0 +1,116 @@
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *memoryTagNames[MEMORY_TAG_COUNT] = {
+    "audio", "entities", "render", "threading", "network", "assets", "saves",
+};
+
+// Shared by every game in the process, allocations come from any thread
+MemoryTracker memoryTracker;
+
+// Files block, the start of an allocation, under tag and returns the
+// memory handed out offset bytes into it
+void *trackAllocation(void *block, size_t offset, int tag, size_t size)
+{
+  if (block == NULL)
+    return NULL;
+
+  MemoryHeader *header = (MemoryHeader *)((char *)block + offset) - 1;
+  header->size = size;
+  header->tag = tag;
+  header->offset = offset;
+
+  MemoryTagStats *stats = &memoryTracker.tags[tag];
+  long long live = atomic_fetch_add(&stats->liveBytes, size) + size;
+  atomic_fetch_add(&stats->liveAllocations, 1);
+
+  long long peak = atomic_load(&stats->peakBytes);
+  while (live > peak &&
+         !atomic_compare_exchange_weak(&stats->peakBytes, &peak, live))
+    ;
+
+  return header + 1;
+}
+
+// malloc that counts towards tag until the block is given to trackedFree
+void *trackedMalloc(int tag, size_t size)
+{
+  return trackAllocation(malloc(sizeof(MemoryHeader) + size),
+                         sizeof(MemoryHeader), tag, size);
+}
+
+void *trackedCalloc(int tag, size_t count, size_t size)
+{
+  return trackAllocation(calloc(1, sizeof(MemoryHeader) + count * size),
+                         sizeof(MemoryHeader), tag, count * size);
+}
+
+// trackedCalloc starting on a cache line, for arrays whose elements are
+// written by different threads side by side
+void *trackedAlignedCalloc(int tag, size_t count, size_t size)
+{
+  // The header takes the line in front, aligned_alloc wants whole lines
+  size_t total = CACHE_LINE_SIZE + count * size;
+  total = (total + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+  void *block = aligned_alloc(CACHE_LINE_SIZE, total);
+  if (block != NULL)
+    memset(block, 0, total);
+
+  return trackAllocation(block, CACHE_LINE_SIZE, tag, count * size);
+}
+
+void trackedFree(void *pointer)
+{
+  if (pointer == NULL)
+    return;
+
+  MemoryHeader *header = (MemoryHeader *)pointer - 1;
+  MemoryTagStats *stats = &memoryTracker.tags[header->tag];
+
+  atomic_fetch_sub(&stats->liveBytes, header->size);
+  atomic_fetch_sub(&stats->liveAllocations, 1);
+
+  free((char *)pointer - header->offset);
+}
+
+long long getTrackedBytes(void)
+{
+  long long total = 0;
+
+  for (int i = 0; i < MEMORY_TAG_COUNT; i++)
+  {
+    total += atomic_load(&memoryTracker.tags[i].liveBytes);
+  }
+
+  return total;
+}
+
+// Lists whatever is still allocated, returns false if anything was
+bool printMemoryReport(void)
+{
+  bool clean = true;
+
+  for (int i = 0; i < MEMORY_TAG_COUNT; i++)
+  {
+    MemoryTagStats *stats = &memoryTracker.tags[i];
+    long long live = atomic_load(&stats->liveBytes);
+    int allocations = atomic_load(&stats->liveAllocations);
+
+    if (allocations > 0)
+    {
+      printf("LEAK: %s still holds %lld bytes in %d allocations (peak %lld)\n",
+             memoryTagNames[i], live, allocations,
+             atomic_load(&stats->peakBytes));
+      clean = false;
+    }
+  }
+
+  if (clean)
+    printf("Memory: no leaks\n");
+
+  return clean;
+}
@@ -0,0 +1,15 @@
+#include "memory_tracker.c"
+
+void *trackAllocation(void *block, size_t offset, int tag, size_t size);
+
+void *trackedMalloc(int tag, size_t size);
+
+void *trackedCalloc(int tag, size_t count, size_t size);
+
+void *trackedAlignedCalloc(int tag, size_t count, size_t size);
+
+void trackedFree(void *pointer);
+
+long long getTrackedBytes(void);
+
+bool printMemoryReport(void);
@@ -0,0 +1,164 @@
+#include <math.h>
+#include <raylib.h>
+#include <stdatomic.h>
+
+void markMinimapChanged(Minimap *minimap)
+{
+  // Most changes find it already set, so skip the write
+  if (!atomic_load_explicit(&minimap->changed, memory_order_relaxed))
+    atomic_store_explicit(&minimap->changed, true, memory_order_relaxed);
+}
+
+// Forgets every entity of a kind
+void clearMinimapKind(Minimap *minimap, int kind)
+{
+  for (int i = 0; i < MINIMAP_SIZE * MINIMAP_SIZE; i++)
+  {
+    atomic_store_explicit(&minimap->counts[kind][i], 0, memory_order_relaxed);
+  }
+
+  for (int i = 0; i < minimap->capacities[kind]; i++)
+  {
+    minimap->slotCells[kind][i] = -1;
+  }
+
+  markMinimapChanged(minimap);
+}
+
+void clearMinimap(Minimap *minimap)
+{
+  for (int kind = 0; kind < MINIMAP_KIND_COUNT; kind++)
+  {
+    clearMinimapKind(minimap, kind);
+  }
+}
+
+// Covers the square [origin, origin + extent) for up to capacities[kind]
+// slots of each kind. Entities outside it count towards the nearest edge cell.
+void initializeMinimap(Minimap *minimap, Vector2 origin, float extent,
+                       const int capacities[MINIMAP_KIND_COUNT])
+{
+  minimap->origin = origin;
+  minimap->cellSize = extent / MINIMAP_SIZE;
+
+  for (int kind = 0; kind < MINIMAP_KIND_COUNT; kind++)
+  {
+    minimap->capacities[kind] = capacities[kind];
+    minimap->counts[kind] = trackedCalloc(
+        MEMORY_ENTITIES, MINIMAP_SIZE * MINIMAP_SIZE, sizeof(atomic_int));
+    minimap->slotCells[kind] =
+        trackedMalloc(MEMORY_ENTITIES, capacities[kind] * sizeof(int));
+  }
+  minimap->pixels =
+      trackedCalloc(MEMORY_RENDER, MINIMAP_SIZE * MINIMAP_SIZE, sizeof(Color));
+
+  clearMinimap(minimap);
+}
+
+int getMinimapCell(Minimap *minimap, Vector2 position)
+{
+  int column =
+      (int)floorf((position.x - minimap->origin.x) / minimap->cellSize);
+  int row = (int)floorf((position.y - minimap->origin.y) / minimap->cellSize);
+
+  if (column < 0)
+    column = 0;
+  if (column >= MINIMAP_SIZE)
+    column = MINIMAP_SIZE - 1;
+  if (row < 0)
+    row = 0;
+  if (row >= MINIMAP_SIZE)
+    row = MINIMAP_SIZE - 1;
+
+  return row * MINIMAP_SIZE + column;
+}
+
+// Counts a slot under the cell its position falls in, taking it out of the
+// cell it was in before. Only touches the counts when it changes cell.
+void placeMinimapEntity(Minimap *minimap, int kind, int slot,
+                        Vector2 position)
+{
+  int cell = getMinimapCell(minimap, position);
+  int oldCell = minimap->slotCells[kind][slot];
+  if (cell == oldCell)
+    return;
+
+  if (oldCell != -1)
+    atomic_fetch_sub_explicit(&minimap->counts[kind][oldCell], 1,
+                              memory_order_relaxed);
+  atomic_fetch_add_explicit(&minimap->counts[kind][cell], 1,
+                            memory_order_relaxed);
+  minimap->slotCells[kind][slot] = cell;
+
+  markMinimapChanged(minimap);
+}
+
+void removeMinimapEntity(Minimap *minimap, int kind, int slot)
+{
+  int cell = minimap->slotCells[kind][slot];
+  if (cell == -1)
+    return;
+
+  atomic_fetch_sub_explicit(&minimap->counts[kind][cell], 1,
+                            memory_order_relaxed);
+  minimap->slotCells[kind][slot] = -1;
+
+  markMinimapChanged(minimap);
+}
+
+// Recounts a kind from scratch, for when its archetype was replaced as a
+// whole rather than entity by entity
+void rebuildMinimapKind(Minimap *minimap, int kind,
+                        EntityArchetype *archetype)
+{
+  clearMinimapKind(minimap, kind);
+
+  for (int i = 0; i < archetype->liveCount; i++)
+  {
+    int slot = archetype->live[i];
+    placeMinimapEntity(minimap, kind, slot, archetype->positions[slot]);
+  }
+}
+
+// Redraws the pixels from the counts and uploads them, only if something
+// changed since the last upload. Costs the same however many entities there
+// are. Main thread only, while jobs may still be updating the counts.
+bool updateMinimapTexture(Minimap *minimap, Texture2D texture)
+{
+  if (!atomic_exchange(&minimap->changed, false))
+    return false;
+
+  for (int i = 0; i < MINIMAP_SIZE * MINIMAP_SIZE; i++)
+  {
+    int enemies = atomic_load_explicit(&minimap->counts[MINIMAP_ENEMY][i],
+                                       memory_order_relaxed);
+    Color color = {20, 20, 20, 200};
+
+    if (enemies > 0)
+    {
+      float heat = fminf((float)enemies / MINIMAP_MAX_ENEMIES, 1);
+      color = (Color){120 + 135 * heat, 30 * heat, 30 * heat, 230};
+    }
+    else if (atomic_load_explicit(&minimap->counts[MINIMAP_CHARGER][i],
+                                  memory_order_relaxed) > 0)
+      color = (Color){200, 200, 200, 230};
+    else if (atomic_load_explicit(&minimap->counts[MINIMAP_CELL][i],
+                                  memory_order_relaxed) > 0)
+      color = (Color){90, 90, 110, 230};
+
+    minimap->pixels[i] = color;
+  }
+
+  UpdateTexture(texture, minimap->pixels);
+  return true;
+}
+
+void destroyMinimap(Minimap *minimap)
+{
+  for (int kind = 0; kind < MINIMAP_KIND_COUNT; kind++)
+  {
+    trackedFree(minimap->counts[kind]);
+    trackedFree(minimap->slotCells[kind]);
+  }
+  trackedFree(minimap->pixels);
+}
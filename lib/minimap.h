@@ -0,0 +1,18 @@
+#include "minimap.c"
+
+void clearMinimap(Minimap *minimap);
+
+void initializeMinimap(Minimap *minimap, Vector2 origin, float extent,
+                       const int capacities[MINIMAP_KIND_COUNT]);
+
+void placeMinimapEntity(Minimap *minimap, int kind, int slot,
+                        Vector2 position);
+
+void removeMinimapEntity(Minimap *minimap, int kind, int slot);
+
+void rebuildMinimapKind(Minimap *minimap, int kind,
+                        EntityArchetype *archetype);
+
+bool updateMinimapTexture(Minimap *minimap, Texture2D texture);
+
+void destroyMinimap(Minimap *minimap);
@@ -1,10 +1,84 @@
+#include <netinet/in.h>
 #include <pthread.h>
 #include <raylib.h>
-#include <semaphore.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_PLAYERS 8
+
+// Data that different threads write at the same time is kept on separate
+// cache lines of this size, so one write doesn't evict the others' copies
+#define CACHE_LINE_SIZE 64
+
+// What an allocation is for, see lib/memory_tracker.h
+enum {
+  MEMORY_AUDIO,
+  MEMORY_ENTITIES,
+  MEMORY_RENDER,
+  MEMORY_THREADING,
+  MEMORY_NETWORK,
+  MEMORY_ASSETS,
+  MEMORY_SAVES,
+  MEMORY_TAG_COUNT
+};
 
-// Player Struct
 typedef struct {
-  Vector2 position;
+  atomic_llong liveBytes, peakBytes;
+  atomic_int liveAllocations;
+} MemoryTagStats;
+
+typedef struct {
+  MemoryTagStats tags[MEMORY_TAG_COUNT];
+} MemoryTracker;
+
+// Sits in front of every tracked block, sized to keep the block aligned
+typedef union {
+  struct {
+    size_t size;
+    int tag;
+    int offset; // from the start of the allocation to the block
+  };
+  max_align_t align;
+} MemoryHeader;
+
+#define TRACE_BUFFER_EVENTS 16384 // per thread, the oldest get overwritten
+#define TRACE_MAX_THREADS 64
+#define TRACE_MAX_DEPTH 16
+
+// How an event shows up on the timeline, see lib/trace_recorder.h
+enum {
+  TRACE_SPAN,
+  TRACE_WAIT,
+};
+
+typedef struct {
+  const char *name; // has to outlive the trace, so a string literal
+  long long start, duration; // nanoseconds
+  int kind;
+} TraceEvent;
+
+// One per thread that has recorded anything, written only by that thread
+typedef struct {
+  char threadName[32];
+  int threadId;
+  atomic_bool recording; // set while the owner is adding an event
+  unsigned long long eventCount; // ever written, wraps around events
+  TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+typedef struct {
+  atomic_bool enabled;
+  long long startTime;
+  pthread_mutex_t mutex; // only taken to add a buffer
+  TraceBuffer *buffers[TRACE_MAX_THREADS];
+  atomic_int bufferCount;
+} TraceRecorder;
+
+// Player Struct, each on its own cache lines since every player is moved by
+// a different job part
+typedef struct {
+  _Alignas(CACHE_LINE_SIZE) Vector2 position;
   int flipDir;
   float speed;
   int size;
@@ -13,38 +87,148 @@ typedef struct {
   pthread_mutex_t mutex;
 } Player;
 
-// Enemy Struct
+// Player input flags
+enum {
+  INPUT_UP = 1 << 0,
+  INPUT_LEFT = 1 << 1,
+  INPUT_DOWN = 1 << 2,
+  INPUT_RIGHT = 1 << 3,
+  INPUT_SHOOT = 1 << 4,
+  INPUT_BUILD_SMALL = 1 << 5,
+  INPUT_BUILD_LARGE = 1 << 6,
+};
+
+// One tick of input for a player, from the keyboard or the network
 typedef struct {
-  Vector2 position;
-  float damage;
-  int speed;
-  int size;
-  bool active;
-  Color color;
-  Sound sound;
-} Enemy;
+  unsigned char held;    // movement keys held down
+  unsigned char pressed; // actions that went down this tick
+} PlayerInput;
 
-// Solar Charger Struct
+// Components an entity archetype can carry, one column each
+enum {
+  COMPONENT_POSITION = 1 << 0,
+  COMPONENT_SIZE = 1 << 1,   // width and height
+  COMPONENT_MOTION = 1 << 2, // speed and contact damage
+  COMPONENT_SOUND = 1 << 3,
+  COMPONENT_VELOCITY = 1 << 4, // velocity per tick and ticks left to live
+  COMPONENT_OWNER = 1 << 5,    // player that made it
+};
+
+// Entities that share a set of components, stored as one contiguous column
+// per component. Columns are indexed by slot, which never changes while the
+// entity lives so events and snapshots can name it. live[0, liveCount) lists
+// the slots in use and the rest of live the free ones, so queries only ever
+// visit live entities.
 typedef struct {
-  int width, height;
-  Vector2 position;
-  bool active;
-} SolarCharger;
+  int components;
+  int capacity;
+  int *live;
+  int *liveIndex; // where each slot sits in live
+  int liveCount;
+
+  Vector2 *positions;
+  Vector2 *sizes;
+  int *speeds;
+  float *damages;
+  Sound *sounds;
+  Vector2 *velocities;
+  int *lifetimes;
+  int *owners;
+} EntityArchetype;
 
 // Viewport Struct
 typedef struct {
   Camera2D *camera;
   RenderTexture2D *renderTexture;
+  Rectangle screenRect; // where the viewport lands on screen
   Player *player;
-  sem_t inputSemaphore;
-  pthread_t thread;
+
+  // Render texture size relative to screenRect, adjusted to hold frame time
+  float resolutionScale;
+  float renderTime; // smoothed GPU seconds spent rendering this viewport
+  int overBudgetSamples, underBudgetSamples; // GPU timings in a row
 } Viewport;
 
+// Uniform grid for finding entities near a point. Each grid cell heads a
+// doubly linked list of the entries whose centre falls inside it.
 typedef struct {
-  Vector2 position;
-  int size;
-  bool active;
-} SolarCell;
+  Vector2 origin;
+  float cellSize;
+  int columns, rows;
+  int capacity;
+  int *heads;       // first entry per grid cell, -1 when empty
+  int *next, *prev; // neighbours in the entry's list, -1 at either end
+  int *gridCells;   // grid cell each entry is filed under, -1 if none
+} SpatialGrid;
+
+// Node of an ObstacleTree, a leaf when it has no children
+typedef struct {
+  Rectangle box;   // bounds of every obstacle under the node
+  int parent;      // -1 for the root
+  int left, right; // children, -1 for a leaf
+  int height;      // 0 for a leaf
+  int entry;       // what a leaf stands for, -1 otherwise
+} ObstacleNode;
+
+// Bounding volume hierarchy over obstacles that never move once placed.
+// Each obstacle is inserted next to the node that grows the tree the least,
+// then the path back to the root is refitted and rebalanced, so placing one
+// only touches that path.
+typedef struct {
+  ObstacleNode *nodes;
+  int nodeCount, maxNodes;
+  int root; // -1 when empty
+} ObstacleTree;
+
+// What the minimap counts
+enum {
+  MINIMAP_ENEMY,
+  MINIMAP_CELL,
+  MINIMAP_CHARGER,
+  MINIMAP_KIND_COUNT
+};
+
+#define MINIMAP_SIZE 64       // cells across, whatever the map size
+#define MINIMAP_MAX_ENEMIES 8 // enemies in a cell for the brightest red
+
+// Entities per cell of the whole map, kept up to date as they are added,
+// removed or cross into another cell, so drawing it never walks the
+// entities. Jobs update it side by side, so the counts are atomic and a
+// slot's cell is only written by the job that owns the slot.
+typedef struct {
+  Vector2 origin;
+  float cellSize;
+  atomic_int *counts[MINIMAP_KIND_COUNT];
+  int *slotCells[MINIMAP_KIND_COUNT]; // cell each slot is in, -1 if none
+  int capacities[MINIMAP_KIND_COUNT];
+  atomic_bool changed; // since the counts were last uploaded
+  Color *pixels;
+} Minimap;
+
+enum {
+  WORLD_CHUNK_UNLOADED, // nobody has been near, nothing generated yet
+  WORLD_CHUNK_ACTIVE,   // contents live in the archetypes
+  WORLD_CHUNK_EVICTED   // contents packed into data
+};
+
+typedef struct {
+  int state;
+  unsigned int randomState; // generates the chunk's solar cells
+  int cellCount, enemyCount;
+  uint16_t *data; // x, y offsets of cells then enemies while evicted
+} WorldChunk;
+
+// The map split into square chunks that are only simulated near players
+typedef struct {
+  Vector2 origin;
+  float chunkSize;
+  int columns, rows;
+  unsigned int seed;
+  WorldChunk *chunks;
+  int *activeChunks; // indices of the active chunks
+  int activeCount;
+  long storedBytes; // held by evicted chunks
+} World;
 
 // Wave Struct
 typedef struct {
@@ -52,78 +236,470 @@ typedef struct {
   int waitTime;   // time in seconds before enemies are spawned
 } EnemyWave;
 
+// How closely an enemy is simulated, by its distance to the nearest player
+enum {
+  ENEMY_TIER_NEAR, // every tick, pushed off its grid neighbours
+  ENEMY_TIER_MID,  // every few ticks, pushed off its grid neighbours
+  ENEMY_TIER_FAR,  // every several ticks, straight at a player
+};
+
+// Releases each wave a few enemies at a time instead of all in one tick
+typedef struct {
+  int pending;   // enemies of started waves still to spawn
+  int ticksLeft; // ticks the pending enemies are spread over
+  int cursor; // walk over the spawn points of the active chunks
+} SpawnDirector;
+
 typedef struct {
   Sound *buffer;
   int currentBuff, buffsize;
 } MultiSound;
 
+// Adaptive resolution controller settings and frame measurements
+typedef struct {
+  bool enabled;
+  float targetFrameTime;
+  float minScale, maxScale, scaleStep;
+
+  // GPU timings a viewport must stay over / well under budget before
+  // rescaling, scaling down reacts quickly while scaling up waits for a
+  // steady frame
+  int downscaleSamples, upscaleSamples;
+  float upscaleHeadroom;
+
+  float cpuTime, compositeTime; // smoothed seconds per frame
+
+  // Timing the GPU stalls the CPU until it catches up, so viewport renders
+  // are only timed every few frames
+  int gpuTimingFrames, framesUntilGpuTiming;
+  bool gpuSampled;  // the last frame drawn was timed
+  bool missedFrame; // an untimed frame ran late since the last timing
+} ResolutionScaler;
+
+#define LATENCY_SAMPLES 256
+
+// Time from polling input to presenting the first frame that shows it
+typedef struct {
+  bool lowLatency; // simulate and draw each tick in the frame it's shown
+
+  float samples[LATENCY_SAMPLES]; // seconds, ring of the latest frames
+  int sampleCount, nextSample;
+  float p50, p95, p99;
+
+  double pollTime;           // when input was last polled
+  double presentedInputTime; // input time of the last recorded frame
+  float latchWorkTime;       // expected seconds from latching to present
+} LatencyTracker;
+
+// Draw layers, drawn back to front
+enum {
+  RENDER_LAYER_CHARGER,
+  RENDER_LAYER_CELL,
+  RENDER_LAYER_ENEMY,
+  RENDER_LAYER_PROJECTILE,
+  RENDER_LAYER_PLAYER,
+  RENDER_LAYER_COUNT
+};
+
+// Snapshot of one visible entity, shared by every viewport
+typedef struct {
+  Rectangle rect;
+  int layer;
+  int index;
+  int flipDir;
+} RenderSprite;
+
+enum {
+  RENDER_COMMAND_RECT,
+  RENDER_COMMAND_TEXT,
+};
+
+// One screen-space draw call, recorded off the main thread
+typedef struct {
+  int type;
+  Rectangle rect; // text only uses x and y
+  Color color;
+  int fontSize;
+  bool centered; // text is centered on rect.x
+  char text[64];
+} RenderCommand;
+
+#define MAX_RENDER_COMMANDS 256
+
+// Below RENDER_DENSITY_ZOOM enemies are drawn as a heat map of how many
+// stand in each RENDER_DENSITY_CELL_SIZE square, with sprites only within
+// RENDER_DENSITY_SPRITE_RANGE of a player. The heat map only covers the
+// zoomed out views, in a texture of RENDER_DENSITY_TEXTURE_SIZE cells a
+// side whose cells double in size until the views fit.
+#define RENDER_DENSITY_ZOOM 0.4f
+#define RENDER_DENSITY_CELL_SIZE 32
+#define RENDER_DENSITY_TEXTURE_SIZE 256
+#define RENDER_DENSITY_SPRITE_RANGE 400
+#define RENDER_DENSITY_MAX 12 // enemies per smallest cell for the hottest
+
+// Everything needed to draw one tick, so the main thread can draw it while
+// the next tick is simulated. Sprites are binned into a world grid and sorted
+// by (layer, cell) so each viewport only walks the cells it can see.
+typedef struct {
+  RenderSprite *sprites, *unsorted;
+  int spriteCount, maxSprites;
+  int *bucketStarts;
+  int gridColumns, gridRows;
+  float cellSize;
+  Vector2 origin;
+  float margin; // largest sprite half-extent, added to view rects
+
+  // Closest enemy in range of each player, -1 if none
+  int aimTargets[MAX_PLAYERS];
+  Vector2 aimTargetPositions[MAX_PLAYERS];
+  Vector2 playerPositions[MAX_PLAYERS];
+  double inputTime; // when the input this tick used was polled
+
+  // Enemies per density cell over the zoomed out views, and the same as
+  // heat map pixels ready to upload. No columns when no view is zoomed out.
+  unsigned short *densityCounts;
+  Color *densityPixels;
+  Vector2 densityOrigin;
+  float densityCellSize;
+  int densityColumns, densityRows;
+  Color densityPalette[RENDER_DENSITY_MAX + 1];
+
+  // Overlays drawn over the composited viewports
+  RenderCommand commands[MAX_RENDER_COMMANDS];
+  int commandCount;
+} RenderPrep;
+
+// Memory-mapped asset bundle produced by tools/pack_assets.c
+typedef struct {
+  void *data;
+  size_t size;
+  int entryCount;
+  struct AssetBundleEntry *entries;
+} AssetBundle;
+
+// A single file decoded on a worker and uploaded on the main thread
+typedef enum {
+  ASSET_QUEUED,
+  ASSET_DECODING,
+  ASSET_DECODED,
+  ASSET_UPLOADED,
+  ASSET_FAILED
+} AssetState;
+
+typedef struct {
+  char path[128];
+  bool isImage;
+  bool fromBundle; // CPU data points into the bundle mapping
+  AssetState state;
+  Wave wave;
+  Image image;
+  Sound sound;
+  Texture2D texture;
+} AssetRequest;
+
 typedef struct {
-  Sound music;
+  AssetRequest *requests;
+  int requestCount, maxRequests;
+  int nextRequest, finishedCount;
+  pthread_mutex_t mutex;
+  pthread_cond_t requestAdded;
+  pthread_t *decoderThreads;
+  int numDecoderThreads;
+  bool stopping;
+  AssetBundle *bundle;
+} AssetManager;
+
+// Background music streamed by its own audio thread
+typedef struct {
+  Music music;
+  bool loaded;
+  bool playing, started, stopping;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t stateChanged;
+} MusicPlayer;
+
+typedef struct {
+  MusicPlayer *music;
   MultiSound *shoot, *pickup, *place, *noAmmo;
   Sound zombie[7];
 
 } GameSound;
 
-// Game Struct
+// Quantised entity state as a network client sees it
 typedef struct {
-  bool paused;
-  bool isQuitting;
+  int16_t x, y;
+  uint16_t a, b; // width & height, or health & facing for players
+  bool present;
+} NetEntity;
+
+// Everything a client knows about the world at one server tick
+typedef struct {
+  uint32_t tick;
+  uint32_t messageFrame; // messages are only resent when this changes
+  NetEntity *entities;
+} NetSnapshot;
+
+#define NET_SNAPSHOT_HISTORY 32
+
+// Server-side state for one connected client
+typedef struct {
+  bool connected;
+  struct sockaddr_in address;
+  double lastHeardTime;
+  uint32_t lastInputSequence;
+  uint32_t ackTick;
+
+  // Edge-triggered actions arrive as counters so lost packets can't drop a
+  // shot, a press is any change since the last counter seen
+  unsigned char pressCounters[3];
+  PlayerInput input;
+
+  float viewHalfWidth, viewHalfHeight;
+  NetSnapshot history[NET_SNAPSHOT_HISTORY];
+} NetClient;
+
+typedef struct {
+  int socket;
+  uint32_t tick;
+  int entityCount;
+  NetClient clients[MAX_PLAYERS];
+  NetEntity *scratch;
+  size_t bytesSent;
+} NetServer;
+
+// Client-side connection to a server
+typedef struct {
+  int socket;
+  struct sockaddr_in serverAddress;
+  bool welcomed;
+  int playerSlot;
+  int entityCount;
+  uint32_t inputSequence, latestTick;
+  unsigned char pressCounters[3];
+  NetSnapshot history[NET_SNAPSHOT_HISTORY];
+  size_t bytesReceived;
+} NetConnection;
+
+// Things the simulation reports to whoever plays sounds and shows messages
+typedef enum {
+  GAME_EVENT_SHOT_FIRED,
+  GAME_EVENT_ENEMY_KILLED,
+  GAME_EVENT_CELL_PICKED,
+  GAME_EVENT_CHARGER_BUILT,
+  GAME_EVENT_NOT_ENOUGH_CELLS,
+  GAME_EVENT_OUT_OF_AMMO,
+  GAME_EVENT_WAVE_STARTED,
+} GameEventType;
+
+typedef struct {
+  GameEventType type;
+  int player; // index of the player behind it, -1 if none
+  int index;  // enemy, cell, charger or wave index
+  Vector2 position;
+} GameEvent;
+
+#define GAME_EVENT_QUEUE_SIZE 1024 // power of two
+
+typedef struct {
+  atomic_uint sequence;
+  GameEvent event;
+} GameEventSlot;
+
+// Bounded lock-free queue, any thread can push, one thread pops
+typedef struct {
+  GameEventSlot slots[GAME_EVENT_QUEUE_SIZE];
+  atomic_uint head; // next slot to write
+  unsigned int tail; // next slot to read, only touched by the consumer
+  atomic_uint dropped;
+} GameEventQueue;
+
+// Called once per part, index runs from 0 to the job's part count
+typedef void (*JobFunction)(void *data, int index);
+
+#define MAX_JOB_DEPENDENTS 8
+
+// A node in a frame's task graph, split into parts that can run in parallel.
+// Parts of neighbouring jobs finish on different threads, so each job gets
+// its own cache lines.
+typedef struct Job {
+  _Alignas(CACHE_LINE_SIZE) const char *name; // for traces
+  JobFunction function;
+  void *data;
+  int partCount;
+  atomic_int unfinishedParts;
+  atomic_int dependencies; // unfinished prerequisites, plus one until submitted
+  struct Job *dependents[MAX_JOB_DEPENDENTS];
+  int dependentCount;
+} Job;
+
+typedef struct {
+  Job *job;
+  int index;
+} JobTask;
+
+#define JOB_QUEUE_SIZE 1024 // power of two
+
+// The owner pushes and pops at the bottom, thieves steal from the top
+typedef struct {
+  _Alignas(CACHE_LINE_SIZE) pthread_mutex_t mutex;
+  JobTask tasks[JOB_QUEUE_SIZE];
+  int top, bottom;
+} JobQueue;
+
+#define MAX_FRAME_JOBS 64
+
+typedef struct {
+  // Queue 0 belongs to the thread that submits and waits, the rest to workers
+  JobQueue *queues;
+  pthread_t *workers;
+  int workerCount, queueCount;
+
+  // Jobs live until waitForJobs returns
+  Job jobs[MAX_FRAME_JOBS];
+  int jobCount;
+  atomic_int pendingJobs;
+
+  atomic_int queuedTasks;
+  bool stopping;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake; // new tasks, all jobs done, or stopping
+} JobSystem;
+
+// Writes snapshots of the game to disk on its own thread
+typedef struct {
+  char path[256];
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  bool busy; // the thread owns the image until it has been written
+  bool stopping;
+  unsigned char *image;
+  size_t imageSize, imageCapacity;
+  int savesWritten;
+} SaveWriter;
+
+typedef struct {
+  JobSystem *system;
+  int queueIndex;
+} JobWorkerArgument;
+
+// Game Struct. Fields are grouped by who writes them while a tick's jobs
+// run. Groups that jobs write start on their own cache line, away from the
+// settings and per-tick state every job reads.
+typedef struct {
+  // Settings, fixed once the simulation is initialized
   int targetFPS;
   int mapSize;
-  bool gameOver, gameWon;
-
+  int playerCount;
+  int gunRange;
+  int maxEnemies;
+  int maxProjectiles;
+  int maxSolarCells;
+  int maxSolarChargers;
   int numWaves;
-  EnemyWave *waves;
+  const EnemyWave *waves;
+  int waveSpawnTicks;   // ticks each wave is spread over
+  int maxSpawnsPerTick; // spawn budget of a single tick
+  bool headless; // no window or audio device, e.g. a dedicated server
 
+  // Written by the main thread between ticks, only read while jobs run
+  int frameCount;
+  unsigned int randomState;
+  bool paused;
+  bool gameOver, gameWon;
   int lastWaveFrame, currentWave;
+  Vector2 viewHalfExtent; // widest view's half size, in world units
+  Vector2 densityHalfExtent; // same for zoomed out views, 0 if none
+  Player *players;
+  PlayerInput playerInputs[MAX_PLAYERS];
+  double inputTime; // when playerInputs were polled
+  Vector2 *enemyPositions; // start of frame in live order, for collisions
+  unsigned char *enemyTiers; // ENEMY_TIER_* by slot
+  int enemyTierCursor; // next live enemy to reassign a tier
+  SpawnDirector spawner;
+  World world;
 
-  int frameCount;
+  // Each archetype is changed by one job at a time, see submitFrameJobs
 
-  float battery;
-  pthread_mutex_t batteryMutex;
+  // Position, size, motion and sound
+  _Alignas(CACHE_LINE_SIZE) EntityArchetype enemies;
+  SpatialGrid enemyGrid; // rebuilt every tick once enemies have moved
 
-  Player *players;
-  int playerCount;
-  int gunRange;
+  // Position, size, velocity and owner
+  _Alignas(CACHE_LINE_SIZE) EntityArchetype projectiles;
+  int *projectileHits; // enemy each live projectile hit this tick, or -1
 
-  Enemy *enemies;
-  int maxEnemies;
+  // Position and size
+  _Alignas(CACHE_LINE_SIZE) EntityArchetype solarCells;
+  SpatialGrid solarCellGrid; // live cells by position
 
-  int solarCellsCollected;
-  int maxSolarCells;
-  SolarCell *solarCells;
-  pthread_mutex_t solarCellsMutex;
+  // Position and size
+  _Alignas(CACHE_LINE_SIZE) EntityArchetype solarChargers;
+  ObstacleTree chargerTree; // walls players and enemies slide along
+
+  // Updated by whichever job adds, removes or moves an entity
+  _Alignas(CACHE_LINE_SIZE) Minimap minimap;
 
-  SolarCharger *solarChargers;
-  pthread_t *solarChargesComputingThreads;
-  int maxSolarChargers, numSolarChargesComputers;
+  // Counters any job may update, each behind its own lock
+  _Alignas(CACHE_LINE_SIZE) pthread_mutex_t batteryMutex;
+  float battery;
 
+  _Alignas(CACHE_LINE_SIZE) pthread_mutex_t enemyCountMutex;
   int enemyCount;
-  pthread_mutex_t enemyCountMutex;
+  int enemiesKilled;
+
+  _Alignas(CACHE_LINE_SIZE) pthread_mutex_t solarCellsMutex;
+  int solarCellsCollected;
+
+  // Main thread only
+  _Alignas(CACHE_LINE_SIZE) bool isQuitting;
+  bool showMemoryOverlay;
 
   char message[256];
   float messageOpacity;
   int messageDuration, messageAddedFrame, messageFontSize;
 
   Viewport *viewports;
+  int viewportCount;
+  ResolutionScaler resolution;
+  LatencyTracker latency;
+  RenderPrep *renderPrep;     // drawn this frame
+  RenderPrep *nextRenderPrep; // filled by the simulation of the next tick
+  Texture2D densityTexture;   // enemy heat map for zoomed out viewports
+  Texture2D minimapTexture;   // one pixel per minimap cell
   Texture2D playerTextures[2];
   Texture2D zombieTexture;
+  RenderTexture2D pausedFrame; // the last frame before pausing, id 0 if none
+  bool pausedFrameValid;
+  bool waitingForInput; // EndDrawing sleeps until there is input
 
   GameSound *sound;
+  AssetManager *assets;
+  GameEventQueue *events; // NULL when nobody listens
+  JobSystem *jobs;
+  SaveWriter *saver; // NULL unless autosaving
+  const char *tracePath; // where F5 and exit write a running trace
 
   int pauseMenuSelection;
   bool showControlsMenu;
   bool showPauseMenu;
 } Game;
 
-// Viewport Thread Arguments Struct
+// A batch of independent headless games stepped together on a job system
 typedef struct {
-  Game *game;
-  int viewportIndex;
-} ViewportThreadArgument;
+  Game *games;
+  int instanceCount;
+  int playerCount;
+  int observationSize;
+  JobSystem *jobs;
 
-// Solar Charger Thread Arguments Struct
-typedef struct {
-  Game *game;
-  int solarChargerComputerIndex;
-} SolarChargingComputerThreadArgument;
+  // Per instance, to turn game state into rewards
+  float *lastHealth;
+  int *lastKills;
+
+  // The step being worked on
+  const PlayerInput *inputs;
+  float *observations, *rewards;
+  bool *dones;
+} GameEnv;
@@ -0,0 +1,118 @@
+#include <pthread.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// How often the audio thread refills the stream buffers. Must stay well
+// below the length of raylib's stream buffers to avoid underruns.
+#define MUSIC_UPDATE_INTERVAL_MS 10
+
+void *streamMusic(void *arg)
+{
+  MusicPlayer *player = (MusicPlayer *)arg;
+
+  pthread_mutex_lock(&player->mutex);
+  while (!player->stopping)
+  {
+    if (!player->playing)
+    {
+      // Parked until the music is resumed or the player is stopped
+      pthread_cond_wait(&player->stateChanged, &player->mutex);
+      continue;
+    }
+
+    UpdateMusicStream(player->music);
+
+    struct timespec wakeTime;
+    clock_gettime(CLOCK_REALTIME, &wakeTime);
+    wakeTime.tv_nsec += MUSIC_UPDATE_INTERVAL_MS * 1000000L;
+    if (wakeTime.tv_nsec >= 1000000000L)
+    {
+      wakeTime.tv_sec++;
+      wakeTime.tv_nsec -= 1000000000L;
+    }
+
+    pthread_cond_timedwait(&player->stateChanged, &player->mutex, &wakeTime);
+  }
+  pthread_mutex_unlock(&player->mutex);
+
+  return NULL;
+}
+
+// Streams the first file that exists, compressed formats first
+MusicPlayer *startMusicPlayer(const char *filenames[], int count)
+{
+  MusicPlayer *player = trackedCalloc(MEMORY_AUDIO, 1, sizeof(MusicPlayer));
+
+  for (int i = 0; i < count && !player->loaded; i++)
+  {
+    if (!FileExists(filenames[i]))
+      continue;
+
+    player->music = LoadMusicStream(filenames[i]);
+    player->loaded = IsMusicValid(player->music);
+  }
+
+  if (!player->loaded)
+  {
+    printf("WARNING: No background music found\n");
+  }
+
+  pthread_mutex_init(&player->mutex, NULL);
+  pthread_cond_init(&player->stateChanged, NULL);
+  pthread_create(&player->thread, NULL, streamMusic, (void *)player);
+
+  return player;
+}
+
+void playMusic(MusicPlayer *player)
+{
+  pthread_mutex_lock(&player->mutex);
+  if (player->loaded && !player->playing)
+  {
+    if (player->started)
+    {
+      ResumeMusicStream(player->music);
+    }
+    else
+    {
+      PlayMusicStream(player->music);
+      player->started = true;
+    }
+
+    player->playing = true;
+    pthread_cond_signal(&player->stateChanged);
+  }
+  pthread_mutex_unlock(&player->mutex);
+}
+
+void pauseMusic(MusicPlayer *player)
+{
+  pthread_mutex_lock(&player->mutex);
+  if (player->playing)
+  {
+    PauseMusicStream(player->music);
+    player->playing = false;
+  }
+  pthread_mutex_unlock(&player->mutex);
+}
+
+void stopMusicPlayer(MusicPlayer *player)
+{
+  pthread_mutex_lock(&player->mutex);
+  player->stopping = true;
+  pthread_cond_signal(&player->stateChanged);
+  pthread_mutex_unlock(&player->mutex);
+
+  pthread_join(player->thread, NULL);
+
+  if (player->loaded)
+  {
+    UnloadMusicStream(player->music);
+  }
+
+  pthread_mutex_destroy(&player->mutex);
+  pthread_cond_destroy(&player->stateChanged);
+  trackedFree(player);
+}
@@ -0,0 +1,9 @@
+#include "music_player.c"
+
+MusicPlayer *startMusicPlayer(const char *filenames[], int count);
+
+void playMusic(MusicPlayer *player);
+
+void pauseMusic(MusicPlayer *player);
+
+void stopMusicPlayer(MusicPlayer *player);
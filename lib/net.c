@@ -0,0 +1,975 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NET_DEFAULT_PORT 7777
+#define NET_MAX_PACKET 1200 // stays under a typical MTU
+#define NET_CLIENT_TIMEOUT 5.0
+
+// Positions are sent as 16-bit integers in units of 1 / NET_POSITION_SCALE,
+// or coarser on maps too big for that to reach the edge
+#define NET_POSITION_SCALE 2
+#define NET_POSITION_MARGIN 200 // room for entities pushed past the edge
+
+// Extra room around a client's view so entities don't pop in at the edges
+#define NET_INTEREST_MARGIN 150
+
+enum
+{
+  NET_PACKET_HELLO = 1,
+  NET_PACKET_WELCOME,
+  NET_PACKET_FULL,
+  NET_PACKET_INPUT,
+  NET_PACKET_SNAPSHOT,
+};
+
+// Entity record field flags
+enum
+{
+  NET_FIELD_REMOVED = 1 << 0,
+  NET_FIELD_POSITION = 1 << 1,
+  NET_FIELD_SMALL_MOVE = 1 << 2, // position as an 8-bit delta on the baseline
+  NET_FIELD_A = 1 << 3,
+  NET_FIELD_B = 1 << 4,
+};
+
+// Global state flags
+enum
+{
+  NET_STATE_PAUSED = 1 << 0,
+  NET_STATE_GAME_OVER = 1 << 1,
+  NET_STATE_GAME_WON = 1 << 2,
+  NET_STATE_MESSAGE = 1 << 3,
+};
+
+// Match settings the server hands to a joining client
+typedef struct
+{
+  int playerSlot;
+  int playerCount;
+  int maxEnemies, maxSolarCells, maxSolarChargers, maxProjectiles;
+  int mapSize, gunRange, targetFPS;
+} NetWelcome;
+
+typedef struct
+{
+  uint8_t data[NET_MAX_PACKET];
+  int size, readPosition;
+  bool overflow;
+} NetBuffer;
+
+double getNetTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void writeU8(NetBuffer *buffer, uint8_t value)
+{
+  if (buffer->size + 1 > NET_MAX_PACKET)
+  {
+    buffer->overflow = true;
+    return;
+  }
+  buffer->data[buffer->size++] = value;
+}
+
+void writeU16(NetBuffer *buffer, uint16_t value)
+{
+  writeU8(buffer, value & 0xFF);
+  writeU8(buffer, value >> 8);
+}
+
+void writeU32(NetBuffer *buffer, uint32_t value)
+{
+  writeU16(buffer, value & 0xFFFF);
+  writeU16(buffer, value >> 16);
+}
+
+uint8_t readU8(NetBuffer *buffer)
+{
+  if (buffer->readPosition + 1 > buffer->size)
+  {
+    buffer->overflow = true;
+    return 0;
+  }
+  return buffer->data[buffer->readPosition++];
+}
+
+uint16_t readU16(NetBuffer *buffer)
+{
+  uint16_t low = readU8(buffer);
+  return low | (uint16_t)readU8(buffer) << 8;
+}
+
+uint32_t readU32(NetBuffer *buffer)
+{
+  uint32_t low = readU16(buffer);
+  return low | (uint32_t)readU16(buffer) << 16;
+}
+
+// Both ends know the map size from the welcome, so they agree on the scale
+float getNetPositionScale(int mapSize)
+{
+  float reach = mapSize / 2.0f + NET_POSITION_MARGIN;
+  return fminf(NET_POSITION_SCALE, INT16_MAX / reach);
+}
+
+int16_t quantizePosition(float value, float scale)
+{
+  float scaled = roundf(value * scale);
+  if (scaled > INT16_MAX)
+    return INT16_MAX;
+  if (scaled < -INT16_MAX)
+    return -INT16_MAX;
+  return (int16_t)scaled;
+}
+
+float dequantizePosition(int16_t value, float scale)
+{
+  return (float)value / scale;
+}
+
+uint16_t clampU16(float value)
+{
+  if (value < 0)
+    return 0;
+  if (value > UINT16_MAX)
+    return UINT16_MAX;
+  return (uint16_t)value;
+}
+
+int openNetSocket(int port)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return -1;
+
+  if (port > 0)
+  {
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  return fd;
+}
+
+// Entity slots: players, then enemies, cells, chargers and projectiles by
+// slot
+int getNetEntityCount(int maxEnemies, int maxSolarCells, int maxSolarChargers,
+                      int maxProjectiles)
+{
+  return MAX_PLAYERS + maxEnemies + maxSolarCells + maxSolarChargers +
+         maxProjectiles;
+}
+
+bool isInInterest(Vector2 position, Vector2 center, float halfWidth,
+                  float halfHeight)
+{
+  return fabsf(position.x - center.x) <= halfWidth &&
+         fabsf(position.y - center.y) <= halfHeight;
+}
+
+void captureNetArchetype(EntityArchetype *archetype, Vector2 center,
+                         float halfWidth, float halfHeight, float scale,
+                         NetEntity *entities)
+{
+  for (int i = 0; i < archetype->liveCount; i++)
+  {
+    int slot = archetype->live[i];
+    Vector2 position = archetype->positions[slot];
+    Vector2 size = archetype->sizes[slot];
+
+    if (isInInterest(position, center, halfWidth, halfHeight))
+    {
+      entities[slot] =
+          (NetEntity){quantizePosition(position.x, scale),
+                      quantizePosition(position.y, scale), size.x, size.y,
+                      true};
+    }
+  }
+}
+
+// Quantises the entities a client should see into slot order
+void captureNetEntities(Game *game, Vector2 center, float halfWidth,
+                        float halfHeight, NetEntity *entities)
+{
+  int enemyBase = MAX_PLAYERS;
+  int cellBase = enemyBase + game->maxEnemies;
+  int chargerBase = cellBase + game->maxSolarCells;
+  int projectileBase = chargerBase + game->maxSolarChargers;
+  float scale = getNetPositionScale(game->mapSize);
+
+  memset(entities, 0,
+         getNetEntityCount(game->maxEnemies, game->maxSolarCells,
+                           game->maxSolarChargers, game->maxProjectiles) *
+             sizeof(NetEntity));
+
+  // Players are always sent
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Player *player = &game->players[i];
+
+    lockTracedMutex(&player->mutex, "player");
+    entities[i] = (NetEntity){quantizePosition(player->position.x, scale),
+                              quantizePosition(player->position.y, scale),
+                              clampU16(player->health * 10),
+                              player->flipDir > 0, true};
+    pthread_mutex_unlock(&player->mutex);
+  }
+
+  captureNetArchetype(&game->enemies, center, halfWidth, halfHeight, scale,
+                      &entities[enemyBase]);
+  captureNetArchetype(&game->solarCells, center, halfWidth, halfHeight, scale,
+                      &entities[cellBase]);
+  captureNetArchetype(&game->solarChargers, center, halfWidth, halfHeight,
+                      scale, &entities[chargerBase]);
+  captureNetArchetype(&game->projectiles, center, halfWidth, halfHeight,
+                      scale, &entities[projectileBase]);
+}
+
+// Also keeps the minimap in step, unless minimapKind is -1
+void applyNetArchetype(EntityArchetype *archetype, NetEntity *entities,
+                       float scale, Minimap *minimap, int minimapKind)
+{
+  for (int i = 0; i < archetype->capacity; i++)
+  {
+    NetEntity *entity = &entities[i];
+
+    if (!entity->present)
+    {
+      if (minimapKind != -1)
+        removeMinimapEntity(minimap, minimapKind, i);
+      removeEntity(archetype, i);
+      continue;
+    }
+
+    addEntityAt(archetype, i);
+    archetype->positions[i] = (Vector2){dequantizePosition(entity->x, scale),
+                                        dequantizePosition(entity->y, scale)};
+    archetype->sizes[i] = (Vector2){entity->a, entity->b};
+
+    if (minimapKind != -1)
+      placeMinimapEntity(minimap, minimapKind, i, archetype->positions[i]);
+  }
+}
+
+// Writes the client's view of the world back into the game's entity arrays
+void applyNetEntities(Game *game, NetEntity *entities)
+{
+  int enemyBase = MAX_PLAYERS;
+  int cellBase = enemyBase + game->maxEnemies;
+  int chargerBase = cellBase + game->maxSolarCells;
+  int projectileBase = chargerBase + game->maxSolarChargers;
+  float scale = getNetPositionScale(game->mapSize);
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    NetEntity *entity = &entities[i];
+    Player *player = &game->players[i];
+
+    lockTracedMutex(&player->mutex, "player");
+    player->position = (Vector2){dequantizePosition(entity->x, scale),
+                                 dequantizePosition(entity->y, scale)};
+    player->health = entity->a / 10.0f;
+    player->flipDir = entity->b ? 1 : -1;
+    pthread_mutex_unlock(&player->mutex);
+  }
+
+  Minimap *minimap = &game->minimap;
+  applyNetArchetype(&game->enemies, &entities[enemyBase], scale, minimap,
+                    MINIMAP_ENEMY);
+  applyNetArchetype(&game->solarCells, &entities[cellBase], scale, minimap,
+                    MINIMAP_CELL);
+  applyNetArchetype(&game->solarChargers, &entities[chargerBase], scale,
+                    minimap, MINIMAP_CHARGER);
+  applyNetArchetype(&game->projectiles, &entities[projectileBase], scale,
+                    minimap, -1);
+}
+
+NetSnapshot *findNetSnapshot(NetSnapshot *history, uint32_t tick)
+{
+  NetSnapshot *snapshot = &history[tick % NET_SNAPSHOT_HISTORY];
+  if (tick == 0 || snapshot->tick != tick)
+    return NULL;
+  return snapshot;
+}
+
+void allocateNetHistory(NetSnapshot *history, int entityCount)
+{
+  for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++)
+  {
+    history[i].tick = 0;
+    history[i].entities =
+        trackedCalloc(MEMORY_NETWORK, entityCount, sizeof(NetEntity));
+  }
+}
+
+void freeNetHistory(NetSnapshot *history)
+{
+  for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++)
+  {
+    trackedFree(history[i].entities);
+    history[i].entities = NULL;
+  }
+}
+
+/*
+    Server
+*/
+
+NetServer *createNetServer(Game *game, int port)
+{
+  int fd = openNetSocket(port);
+  if (fd < 0)
+  {
+    printf("ERROR: Cannot listen on UDP port %d\n", port);
+    return NULL;
+  }
+
+  NetServer *server = trackedCalloc(MEMORY_NETWORK, 1, sizeof(NetServer));
+  server->socket = fd;
+  server->entityCount =
+      getNetEntityCount(game->maxEnemies, game->maxSolarCells,
+                        game->maxSolarChargers, game->maxProjectiles);
+  server->scratch =
+      trackedCalloc(MEMORY_NETWORK, server->entityCount, sizeof(NetEntity));
+
+  for (int i = 0; i < MAX_PLAYERS; i++)
+  {
+    allocateNetHistory(server->clients[i].history, server->entityCount);
+  }
+
+  printf("Server listening on UDP port %d\n", port);
+  return server;
+}
+
+void sendNetBuffer(int fd, NetBuffer *buffer, struct sockaddr_in *address)
+{
+  sendto(fd, buffer->data, buffer->size, 0, (struct sockaddr *)address,
+         sizeof(*address));
+}
+
+void sendNetWelcome(NetServer *server, Game *game, int slot)
+{
+  NetBuffer buffer = {0};
+  writeU8(&buffer, NET_PACKET_WELCOME);
+  writeU8(&buffer, slot);
+  writeU8(&buffer, game->playerCount);
+  writeU16(&buffer, game->maxEnemies);
+  writeU16(&buffer, game->maxSolarCells);
+  writeU16(&buffer, game->maxSolarChargers);
+  writeU16(&buffer, game->maxProjectiles);
+  writeU32(&buffer, game->mapSize);
+  writeU16(&buffer, game->gunRange);
+  writeU8(&buffer, game->targetFPS);
+
+  sendNetBuffer(server->socket, &buffer, &server->clients[slot].address);
+}
+
+int findNetClient(NetServer *server, Game *game, struct sockaddr_in *address)
+{
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    NetClient *client = &server->clients[i];
+    if (client->connected &&
+        client->address.sin_addr.s_addr == address->sin_addr.s_addr &&
+        client->address.sin_port == address->sin_port)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void handleNetHello(NetServer *server, Game *game, struct sockaddr_in *address)
+{
+  int slot = findNetClient(server, game, address);
+
+  for (int i = 0; i < game->playerCount && slot == -1; i++)
+  {
+    if (!server->clients[i].connected)
+    {
+      NetClient *client = &server->clients[i];
+      slot = i;
+
+      client->connected = true;
+      client->address = *address;
+      client->lastInputSequence = 0;
+      client->ackTick = 0;
+      client->input = (PlayerInput){0, 0};
+      memset(client->pressCounters, 0, sizeof(client->pressCounters));
+
+      printf("Player %d joined from %s:%d\n", slot + 1,
+             inet_ntoa(address->sin_addr), ntohs(address->sin_port));
+    }
+  }
+
+  if (slot == -1)
+  {
+    NetBuffer buffer = {0};
+    writeU8(&buffer, NET_PACKET_FULL);
+    sendNetBuffer(server->socket, &buffer, address);
+    return;
+  }
+
+  // Resent for every hello in case the previous welcome was lost
+  server->clients[slot].lastHeardTime = getNetTime();
+  sendNetWelcome(server, game, slot);
+}
+
+void handleNetInput(NetServer *server, Game *game, NetBuffer *buffer,
+                    struct sockaddr_in *address)
+{
+  int slot = findNetClient(server, game, address);
+  if (slot == -1)
+    return;
+
+  NetClient *client = &server->clients[slot];
+
+  uint32_t sequence = readU32(buffer);
+  uint32_t ackTick = readU32(buffer);
+  uint8_t held = readU8(buffer);
+  uint8_t pressCounters[3];
+  for (int i = 0; i < 3; i++)
+    pressCounters[i] = readU8(buffer);
+  uint16_t viewHalfWidth = readU16(buffer);
+  uint16_t viewHalfHeight = readU16(buffer);
+
+  // Drop reordered or truncated packets
+  if (buffer->overflow || sequence <= client->lastInputSequence)
+    return;
+
+  client->lastInputSequence = sequence;
+  client->lastHeardTime = getNetTime();
+  if (ackTick > client->ackTick)
+    client->ackTick = ackTick;
+
+  client->input.held = held;
+
+  unsigned char actions[3] = {INPUT_SHOOT, INPUT_BUILD_SMALL,
+                              INPUT_BUILD_LARGE};
+  for (int i = 0; i < 3; i++)
+  {
+    if (pressCounters[i] != client->pressCounters[i])
+    {
+      client->input.pressed |= actions[i];
+      client->pressCounters[i] = pressCounters[i];
+    }
+  }
+
+  client->viewHalfWidth = viewHalfWidth;
+  client->viewHalfHeight = viewHalfHeight;
+}
+
+// Drains every pending packet and drops clients that went quiet
+void receiveNetInputs(NetServer *server, Game *game)
+{
+  NetBuffer buffer;
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+
+  while (true)
+  {
+    buffer.readPosition = 0;
+    buffer.overflow = false;
+    buffer.size = recvfrom(server->socket, buffer.data, NET_MAX_PACKET, 0,
+                           (struct sockaddr *)&address, &addressLength);
+    if (buffer.size <= 0)
+      break;
+
+    uint8_t type = readU8(&buffer);
+    if (type == NET_PACKET_HELLO)
+      handleNetHello(server, game, &address);
+    else if (type == NET_PACKET_INPUT)
+      handleNetInput(server, game, &buffer, &address);
+  }
+
+  double now = getNetTime();
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    NetClient *client = &server->clients[i];
+    if (client->connected && now - client->lastHeardTime > NET_CLIENT_TIMEOUT)
+    {
+      printf("Player %d timed out\n", i + 1);
+      client->connected = false;
+    }
+  }
+
+  // Enemies get the full update as far as the widest client view reaches,
+  // the server has no view of its own
+  Vector2 extent = {0, 0};
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    NetClient *client = &server->clients[i];
+    if (!client->connected)
+      continue;
+
+    extent.x = fmaxf(extent.x, client->viewHalfWidth);
+    extent.y = fmaxf(extent.y, client->viewHalfHeight);
+  }
+  if (extent.x > 0 && extent.y > 0)
+    game->viewHalfExtent = extent;
+}
+
+// Returns the client's input for this tick, presses are only reported once
+PlayerInput consumeNetInput(NetServer *server, int slot)
+{
+  NetClient *client = &server->clients[slot];
+  PlayerInput input = client->input;
+  client->input.pressed = 0;
+
+  if (!client->connected)
+    return (PlayerInput){0, 0};
+
+  return input;
+}
+
+bool netEntitiesEqual(NetEntity *a, NetEntity *b)
+{
+  return a->x == b->x && a->y == b->y && a->a == b->a && a->b == b->b;
+}
+
+void writeNetSnapshot(NetServer *server, Game *game, NetClient *client,
+                      int slot, NetBuffer *buffer)
+{
+  NetSnapshot *baseline = findNetSnapshot(client->history, client->ackTick);
+  if (baseline != NULL && server->tick - baseline->tick >= NET_SNAPSHOT_HISTORY)
+    baseline = NULL;
+
+  // The new snapshot starts as what the client already has and records
+  // exactly what this packet changes, so it can serve as a later baseline
+  NetSnapshot *snapshot = &client->history[server->tick % NET_SNAPSHOT_HISTORY];
+  snapshot->tick = server->tick;
+  snapshot->messageFrame = baseline ? baseline->messageFrame : UINT32_MAX;
+  if (baseline)
+    memcpy(snapshot->entities, baseline->entities,
+           server->entityCount * sizeof(NetEntity));
+  else
+    memset(snapshot->entities, 0, server->entityCount * sizeof(NetEntity));
+
+  lockTracedMutex(&game->players[slot].mutex, "player");
+  Vector2 center = game->players[slot].position;
+  pthread_mutex_unlock(&game->players[slot].mutex);
+
+  captureNetEntities(game, center, client->viewHalfWidth + NET_INTEREST_MARGIN,
+                     client->viewHalfHeight + NET_INTEREST_MARGIN,
+                     server->scratch);
+
+  bool sendMessage = snapshot->messageFrame != (uint32_t)game->messageAddedFrame;
+
+  uint8_t flags = (game->paused ? NET_STATE_PAUSED : 0) |
+                  (game->gameOver ? NET_STATE_GAME_OVER : 0) |
+                  (game->gameWon ? NET_STATE_GAME_WON : 0) |
+                  (sendMessage ? NET_STATE_MESSAGE : 0);
+
+  writeU8(buffer, NET_PACKET_SNAPSHOT);
+  writeU32(buffer, server->tick);
+  writeU32(buffer, baseline ? baseline->tick : 0);
+  writeU32(buffer, game->frameCount);
+  writeU32(buffer, game->lastWaveFrame);
+  writeU16(buffer, clampU16(game->battery * 10));
+  writeU16(buffer, game->solarCellsCollected);
+  writeU16(buffer, game->enemyCount);
+  writeU8(buffer, game->currentWave);
+  writeU8(buffer, flags);
+
+  if (sendMessage)
+  {
+    int length = strlen(game->message);
+    if (length > 255)
+      length = 255;
+
+    writeU32(buffer, game->messageAddedFrame);
+    writeU8(buffer, game->messageFontSize);
+    writeU8(buffer, length);
+    for (int i = 0; i < length; i++)
+      writeU8(buffer, game->message[i]);
+
+    snapshot->messageFrame = game->messageAddedFrame;
+  }
+
+  int countPosition = buffer->size;
+  int recordCount = 0;
+  writeU16(buffer, 0);
+
+  for (int i = 0; i < server->entityCount; i++)
+  {
+    NetEntity *current = &server->scratch[i];
+    NetEntity *known = &snapshot->entities[i];
+
+    if (!current->present && !known->present)
+      continue;
+    if (current->present && known->present && netEntitiesEqual(current, known))
+      continue;
+
+    uint8_t mask = 0;
+    int recordSize = 3;
+
+    if (!current->present)
+    {
+      mask = NET_FIELD_REMOVED;
+    }
+    else if (!known->present)
+    {
+      mask = NET_FIELD_POSITION | NET_FIELD_A | NET_FIELD_B;
+      recordSize += 8;
+    }
+    else
+    {
+      int dx = current->x - known->x;
+      int dy = current->y - known->y;
+
+      if (dx != 0 || dy != 0)
+      {
+        bool small = dx >= INT8_MIN && dx <= INT8_MAX && dy >= INT8_MIN &&
+                     dy <= INT8_MAX;
+        mask |= small ? NET_FIELD_SMALL_MOVE : NET_FIELD_POSITION;
+        recordSize += small ? 2 : 4;
+      }
+      if (current->a != known->a)
+      {
+        mask |= NET_FIELD_A;
+        recordSize += 2;
+      }
+      if (current->b != known->b)
+      {
+        mask |= NET_FIELD_B;
+        recordSize += 2;
+      }
+    }
+
+    // Whatever doesn't fit goes out in a later snapshot
+    if (buffer->size + recordSize > NET_MAX_PACKET)
+      break;
+
+    writeU16(buffer, i);
+    writeU8(buffer, mask);
+
+    if (mask & NET_FIELD_POSITION)
+    {
+      writeU16(buffer, (uint16_t)current->x);
+      writeU16(buffer, (uint16_t)current->y);
+    }
+    if (mask & NET_FIELD_SMALL_MOVE)
+    {
+      writeU8(buffer, (uint8_t)(int8_t)(current->x - known->x));
+      writeU8(buffer, (uint8_t)(int8_t)(current->y - known->y));
+    }
+    if (mask & NET_FIELD_A)
+      writeU16(buffer, current->a);
+    if (mask & NET_FIELD_B)
+      writeU16(buffer, current->b);
+
+    *known = *current;
+    recordCount++;
+  }
+
+  buffer->data[countPosition] = recordCount & 0xFF;
+  buffer->data[countPosition + 1] = recordCount >> 8;
+}
+
+void sendNetSnapshots(NetServer *server, Game *game)
+{
+  server->tick++;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    NetClient *client = &server->clients[i];
+    if (!client->connected)
+      continue;
+
+    NetBuffer buffer = {0};
+    writeNetSnapshot(server, game, client, i, &buffer);
+    sendNetBuffer(server->socket, &buffer, &client->address);
+    server->bytesSent += buffer.size;
+  }
+}
+
+void destroyNetServer(NetServer *server)
+{
+  for (int i = 0; i < MAX_PLAYERS; i++)
+  {
+    freeNetHistory(server->clients[i].history);
+  }
+
+  close(server->socket);
+  trackedFree(server->scratch);
+  trackedFree(server);
+}
+
+/*
+    Client
+*/
+
+NetConnection *connectToServer(const char *host, int port)
+{
+  struct addrinfo hints = {0}, *result;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  if (getaddrinfo(host, NULL, &hints, &result) != 0)
+  {
+    printf("ERROR: Cannot resolve %s\n", host);
+    return NULL;
+  }
+
+  int fd = openNetSocket(0);
+  if (fd < 0)
+  {
+    freeaddrinfo(result);
+    return NULL;
+  }
+
+  NetConnection *connection =
+      trackedCalloc(MEMORY_NETWORK, 1, sizeof(NetConnection));
+  connection->socket = fd;
+  connection->serverAddress = *(struct sockaddr_in *)result->ai_addr;
+  connection->serverAddress.sin_port = htons(port);
+  connection->playerSlot = -1;
+  freeaddrinfo(result);
+
+  return connection;
+}
+
+void sendNetHello(NetConnection *connection)
+{
+  NetBuffer buffer = {0};
+  writeU8(&buffer, NET_PACKET_HELLO);
+  sendNetBuffer(connection->socket, &buffer, &connection->serverAddress);
+}
+
+// Returns 1 once welcomed, -1 if the server is full, 0 while waiting
+int pollNetWelcome(NetConnection *connection, NetWelcome *welcome)
+{
+  NetBuffer buffer;
+
+  while (true)
+  {
+    buffer.readPosition = 0;
+    buffer.overflow = false;
+    buffer.size = recv(connection->socket, buffer.data, NET_MAX_PACKET, 0);
+    if (buffer.size <= 0)
+      return 0;
+
+    uint8_t type = readU8(&buffer);
+    if (type == NET_PACKET_FULL)
+      return -1;
+    if (type != NET_PACKET_WELCOME)
+      continue;
+
+    welcome->playerSlot = readU8(&buffer);
+    welcome->playerCount = readU8(&buffer);
+    welcome->maxEnemies = readU16(&buffer);
+    welcome->maxSolarCells = readU16(&buffer);
+    welcome->maxSolarChargers = readU16(&buffer);
+    welcome->maxProjectiles = readU16(&buffer);
+    welcome->mapSize = readU32(&buffer);
+    welcome->gunRange = readU16(&buffer);
+    welcome->targetFPS = readU8(&buffer);
+
+    if (buffer.overflow || welcome->playerSlot >= welcome->playerCount ||
+        welcome->playerCount > MAX_PLAYERS)
+      continue;
+
+    connection->welcomed = true;
+    connection->playerSlot = welcome->playerSlot;
+    connection->entityCount =
+        getNetEntityCount(welcome->maxEnemies, welcome->maxSolarCells,
+                          welcome->maxSolarChargers, welcome->maxProjectiles);
+    allocateNetHistory(connection->history, connection->entityCount);
+
+    return 1;
+  }
+}
+
+void sendNetInput(NetConnection *connection, PlayerInput input,
+                  float viewHalfWidth, float viewHalfHeight)
+{
+  unsigned char actions[3] = {INPUT_SHOOT, INPUT_BUILD_SMALL,
+                              INPUT_BUILD_LARGE};
+  for (int i = 0; i < 3; i++)
+  {
+    if (input.pressed & actions[i])
+      connection->pressCounters[i]++;
+  }
+
+  NetBuffer buffer = {0};
+  writeU8(&buffer, NET_PACKET_INPUT);
+  writeU32(&buffer, ++connection->inputSequence);
+  writeU32(&buffer, connection->latestTick);
+  writeU8(&buffer, input.held);
+  for (int i = 0; i < 3; i++)
+    writeU8(&buffer, connection->pressCounters[i]);
+  writeU16(&buffer, clampU16(viewHalfWidth));
+  writeU16(&buffer, clampU16(viewHalfHeight));
+
+  sendNetBuffer(connection->socket, &buffer, &connection->serverAddress);
+}
+
+// Rebuilds one snapshot from its baseline, applying it to the game if it is
+// the newest seen. Returns false for packets that can't be decoded.
+bool readNetSnapshot(NetConnection *connection, Game *game, NetBuffer *buffer)
+{
+  uint32_t tick = readU32(buffer);
+  uint32_t baselineTick = readU32(buffer);
+
+  NetSnapshot *baseline = NULL;
+  if (baselineTick != 0)
+  {
+    baseline = findNetSnapshot(connection->history, baselineTick);
+    if (baseline == NULL)
+      return false;
+  }
+
+  if (findNetSnapshot(connection->history, tick) != NULL ||
+      tick + NET_SNAPSHOT_HISTORY <= connection->latestTick)
+    return false;
+
+  uint32_t frameCount = readU32(buffer);
+  uint32_t lastWaveFrame = readU32(buffer);
+  uint16_t battery = readU16(buffer);
+  uint16_t solarCellsCollected = readU16(buffer);
+  uint16_t enemyCount = readU16(buffer);
+  uint8_t currentWave = readU8(buffer);
+  uint8_t flags = readU8(buffer);
+
+  char message[256] = "";
+  uint32_t messageFrame = baseline ? baseline->messageFrame : UINT32_MAX;
+  int messageFontSize = 0;
+
+  if (flags & NET_STATE_MESSAGE)
+  {
+    messageFrame = readU32(buffer);
+    messageFontSize = readU8(buffer);
+    int length = readU8(buffer);
+    for (int i = 0; i < length; i++)
+      message[i] = readU8(buffer);
+    message[length] = '\0';
+  }
+
+  NetSnapshot *snapshot = &connection->history[tick % NET_SNAPSHOT_HISTORY];
+  if (baseline)
+    memcpy(snapshot->entities, baseline->entities,
+           connection->entityCount * sizeof(NetEntity));
+  else
+    memset(snapshot->entities, 0, connection->entityCount * sizeof(NetEntity));
+
+  int recordCount = readU16(buffer);
+  for (int i = 0; i < recordCount && !buffer->overflow; i++)
+  {
+    uint16_t slot = readU16(buffer);
+    uint8_t mask = readU8(buffer);
+
+    if (slot >= connection->entityCount)
+    {
+      buffer->overflow = true;
+      break;
+    }
+
+    NetEntity *entity = &snapshot->entities[slot];
+
+    if (mask & NET_FIELD_REMOVED)
+    {
+      entity->present = false;
+      continue;
+    }
+
+    entity->present = true;
+    if (mask & NET_FIELD_POSITION)
+    {
+      entity->x = (int16_t)readU16(buffer);
+      entity->y = (int16_t)readU16(buffer);
+    }
+    if (mask & NET_FIELD_SMALL_MOVE)
+    {
+      entity->x += (int8_t)readU8(buffer);
+      entity->y += (int8_t)readU8(buffer);
+    }
+    if (mask & NET_FIELD_A)
+      entity->a = readU16(buffer);
+    if (mask & NET_FIELD_B)
+      entity->b = readU16(buffer);
+  }
+
+  if (buffer->overflow)
+  {
+    snapshot->tick = 0;
+    return false;
+  }
+
+  snapshot->tick = tick;
+  snapshot->messageFrame = messageFrame;
+
+  if (tick <= connection->latestTick)
+    return true;
+
+  connection->latestTick = tick;
+
+  game->frameCount = frameCount;
+  game->lastWaveFrame = lastWaveFrame;
+  game->battery = battery / 10.0f;
+  game->solarCellsCollected = solarCellsCollected;
+  game->enemyCount = enemyCount;
+  game->currentWave = currentWave;
+  game->paused = flags & NET_STATE_PAUSED;
+  game->gameOver = flags & NET_STATE_GAME_OVER;
+  game->gameWon = flags & NET_STATE_GAME_WON;
+
+  if (flags & NET_STATE_MESSAGE)
+  {
+    sprintf(game->message, "%s", message);
+    game->messageFontSize = messageFontSize;
+    game->messageAddedFrame = messageFrame;
+  }
+
+  applyNetEntities(game, snapshot->entities);
+  return true;
+}
+
+void receiveNetSnapshots(NetConnection *connection, Game *game)
+{
+  NetBuffer buffer;
+
+  while (true)
+  {
+    buffer.readPosition = 0;
+    buffer.overflow = false;
+    buffer.size = recv(connection->socket, buffer.data, NET_MAX_PACKET, 0);
+    if (buffer.size <= 0)
+      break;
+
+    connection->bytesReceived += buffer.size;
+
+    if (readU8(&buffer) == NET_PACKET_SNAPSHOT)
+      readNetSnapshot(connection, game, &buffer);
+  }
+}
+
+void closeConnection(NetConnection *connection)
+{
+  if (connection->welcomed)
+    freeNetHistory(connection->history);
+
+  close(connection->socket);
+  trackedFree(connection);
+}
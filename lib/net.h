@@ -0,0 +1,34 @@
+#include "net.c"
+
+double getNetTime(void);
+
+int getNetEntityCount(int maxEnemies, int maxSolarCells, int maxSolarChargers,
+                      int maxProjectiles);
+
+void captureNetEntities(Game *game, Vector2 center, float halfWidth,
+                        float halfHeight, NetEntity *entities);
+
+void applyNetEntities(Game *game, NetEntity *entities);
+
+NetServer *createNetServer(Game *game, int port);
+
+void receiveNetInputs(NetServer *server, Game *game);
+
+PlayerInput consumeNetInput(NetServer *server, int slot);
+
+void sendNetSnapshots(NetServer *server, Game *game);
+
+void destroyNetServer(NetServer *server);
+
+NetConnection *connectToServer(const char *host, int port);
+
+void sendNetHello(NetConnection *connection);
+
+int pollNetWelcome(NetConnection *connection, NetWelcome *welcome);
+
+void sendNetInput(NetConnection *connection, PlayerInput input,
+                  float viewHalfWidth, float viewHalfHeight);
+
+void receiveNetSnapshots(NetConnection *connection, Game *game);
+
+void closeConnection(NetConnection *connection);
@@ -0,0 +1,195 @@
+#include <math.h>
+#include <raylib.h>
+
+void clearObstacleTree(ObstacleTree *tree)
+{
+  tree->nodeCount = 0;
+  tree->root = -1;
+}
+
+// Room for up to capacity obstacles
+void initializeObstacleTree(ObstacleTree *tree, int capacity)
+{
+  // A binary tree over n leaves has n - 1 inner nodes
+  tree->maxNodes = capacity > 0 ? capacity * 2 - 1 : 0;
+  tree->nodes =
+      trackedMalloc(MEMORY_ENTITIES, tree->maxNodes * sizeof(ObstacleNode));
+
+  clearObstacleTree(tree);
+}
+
+Rectangle mergeObstacleBoxes(Rectangle a, Rectangle b)
+{
+  float minX = fminf(a.x, b.x);
+  float minY = fminf(a.y, b.y);
+  float maxX = fmaxf(a.x + a.width, b.x + b.width);
+  float maxY = fmaxf(a.y + a.height, b.y + b.height);
+
+  return (Rectangle){minX, minY, maxX - minX, maxY - minY};
+}
+
+float getObstacleBoxPerimeter(Rectangle box)
+{
+  return 2 * (box.width + box.height);
+}
+
+// How much the tree grows if box goes somewhere under node
+float getObstacleDescentCost(ObstacleNode *node, Rectangle box)
+{
+  float merged = getObstacleBoxPerimeter(mergeObstacleBoxes(node->box, box));
+  if (node->left == -1)
+    return merged;
+  return merged - getObstacleBoxPerimeter(node->box);
+}
+
+// Points whatever held child at replacement instead, parent -1 is the root
+void replaceObstacleChild(ObstacleTree *tree, int parent, int child,
+                          int replacement)
+{
+  if (parent == -1)
+    tree->root = replacement;
+  else if (tree->nodes[parent].left == child)
+    tree->nodes[parent].left = replacement;
+  else
+    tree->nodes[parent].right = replacement;
+}
+
+// Fits an inner node's box and height to its children
+void refitObstacleNode(ObstacleTree *tree, int index)
+{
+  ObstacleNode *node = &tree->nodes[index];
+  ObstacleNode *left = &tree->nodes[node->left];
+  ObstacleNode *right = &tree->nodes[node->right];
+
+  node->box = mergeObstacleBoxes(left->box, right->box);
+  node->height = 1 + (left->height > right->height ? left->height
+                                                   : right->height);
+}
+
+// Lifts the taller child of a lopsided node into its place, as in an AVL
+// tree, and returns the node now at the top. Walls placed in a row would
+// otherwise grow the tree into a list.
+int balanceObstacleNode(ObstacleTree *tree, int index)
+{
+  ObstacleNode *nodes = tree->nodes;
+  ObstacleNode *node = &nodes[index];
+  if (node->left == -1 || node->height < 2)
+    return index;
+
+  int balance = nodes[node->right].height - nodes[node->left].height;
+  if (balance >= -1 && balance <= 1)
+    return index;
+
+  int up = balance > 1 ? node->right : node->left;
+  ObstacleNode *upNode = &nodes[up];
+
+  // The lifted child keeps its taller child, the shorter one moves down
+  int tall = nodes[upNode->left].height > nodes[upNode->right].height
+                 ? upNode->left
+                 : upNode->right;
+  int low = tall == upNode->left ? upNode->right : upNode->left;
+
+  replaceObstacleChild(tree, node->parent, index, up);
+  upNode->parent = node->parent;
+  upNode->left = index;
+  upNode->right = tall;
+
+  replaceObstacleChild(tree, index, up, low);
+  nodes[low].parent = index;
+  node->parent = up;
+
+  refitObstacleNode(tree, index);
+  refitObstacleNode(tree, up);
+  return up;
+}
+
+// Adds an obstacle, returns false if the tree is full
+bool insertObstacle(ObstacleTree *tree, int entry, Rectangle box)
+{
+  // A leaf, plus a parent for it unless it becomes the root
+  int needed = tree->root == -1 ? 1 : 2;
+  if (tree->nodeCount + needed > tree->maxNodes)
+    return false;
+
+  ObstacleNode *nodes = tree->nodes;
+  int leaf = tree->nodeCount++;
+  nodes[leaf] = (ObstacleNode){box, -1, -1, -1, 0, entry};
+
+  if (tree->root == -1)
+  {
+    tree->root = leaf;
+    return true;
+  }
+
+  // Walk down while pairing with a child costs less than pairing here,
+  // counting the growth of every box on the way (the perimeter heuristic)
+  int sibling = tree->root;
+  while (nodes[sibling].left != -1)
+  {
+    ObstacleNode *node = &nodes[sibling];
+    float merged = getObstacleBoxPerimeter(mergeObstacleBoxes(node->box, box));
+
+    float cost = 2 * merged;
+    float inherited = 2 * (merged - getObstacleBoxPerimeter(node->box));
+    float leftCost =
+        getObstacleDescentCost(&nodes[node->left], box) + inherited;
+    float rightCost =
+        getObstacleDescentCost(&nodes[node->right], box) + inherited;
+
+    if (cost < leftCost && cost < rightCost)
+      break;
+
+    sibling = leftCost < rightCost ? node->left : node->right;
+  }
+
+  // A new parent takes the sibling's place, holding it and the leaf
+  int oldParent = nodes[sibling].parent;
+  int parent = tree->nodeCount++;
+  nodes[parent] = (ObstacleNode){box, oldParent, sibling, leaf, 0, -1};
+  replaceObstacleChild(tree, oldParent, sibling, parent);
+  nodes[sibling].parent = parent;
+  nodes[leaf].parent = parent;
+
+  // Grow the boxes above to fit, rebalancing on the way up
+  for (int i = parent; i != -1; i = nodes[i].parent)
+  {
+    i = balanceObstacleNode(tree, i);
+    refitObstacleNode(tree, i);
+  }
+
+  return true;
+}
+
+int queryObstacleNode(ObstacleTree *tree, int index, Rectangle area,
+                      Rectangle *hits, int hitCount, int maxHits)
+{
+  ObstacleNode *node = &tree->nodes[index];
+
+  if (hitCount == maxHits || !CheckCollisionRecs(node->box, area))
+    return hitCount;
+
+  if (node->left == -1)
+  {
+    hits[hitCount] = node->box;
+    return hitCount + 1;
+  }
+
+  hitCount = queryObstacleNode(tree, node->left, area, hits, hitCount, maxHits);
+  return queryObstacleNode(tree, node->right, area, hits, hitCount, maxHits);
+}
+
+// Fills hits with the boxes of up to maxHits obstacles overlapping area and
+// returns how many. Read-only, so any number of jobs can query at once.
+int queryObstacleTree(ObstacleTree *tree, Rectangle area, Rectangle *hits,
+                      int maxHits)
+{
+  if (tree->root == -1)
+    return 0;
+
+  return queryObstacleNode(tree, tree->root, area, hits, 0, maxHits);
+}
+
+void destroyObstacleTree(ObstacleTree *tree)
+{
+  trackedFree(tree->nodes);
+}
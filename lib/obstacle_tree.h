@@ -0,0 +1,12 @@
+#include "obstacle_tree.c"
+
+void clearObstacleTree(ObstacleTree *tree);
+
+void initializeObstacleTree(ObstacleTree *tree, int capacity);
+
+bool insertObstacle(ObstacleTree *tree, int entry, Rectangle box);
+
+int queryObstacleTree(ObstacleTree *tree, Rectangle area, Rectangle *hits,
+                      int maxHits);
+
+void destroyObstacleTree(ObstacleTree *tree);
@@ -0,0 +1,359 @@
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+RenderPrep *createRenderPrep(Game *game, float cellSize)
+{
+  RenderPrep *prep = trackedCalloc(MEMORY_RENDER, 1, sizeof(RenderPrep));
+
+  prep->maxSprites = game->maxSolarChargers + game->maxSolarCells +
+                     game->maxEnemies + game->maxProjectiles +
+                     game->playerCount;
+  prep->sprites =
+      trackedCalloc(MEMORY_RENDER, prep->maxSprites, sizeof(RenderSprite));
+  prep->unsorted =
+      trackedCalloc(MEMORY_RENDER, prep->maxSprites, sizeof(RenderSprite));
+
+  prep->cellSize = cellSize;
+  prep->gridColumns = (int)ceilf(game->mapSize / cellSize);
+  prep->gridRows = prep->gridColumns;
+  prep->origin = (Vector2){-game->mapSize / 2.0f, -game->mapSize / 2.0f};
+
+  prep->bucketStarts = trackedCalloc(
+      MEMORY_RENDER, RENDER_LAYER_COUNT * prep->gridColumns * prep->gridRows + 1,
+      sizeof(int));
+
+  int densityCells = RENDER_DENSITY_TEXTURE_SIZE * RENDER_DENSITY_TEXTURE_SIZE;
+  prep->densityCounts =
+      trackedCalloc(MEMORY_RENDER, densityCells, sizeof(unsigned short));
+  prep->densityPixels =
+      trackedCalloc(MEMORY_RENDER, densityCells, sizeof(Color));
+
+  // Dim red for a lone enemy up to yellow for a packed cell, more opaque as
+  // it gets hotter
+  for (int i = 1; i <= RENDER_DENSITY_MAX; i++)
+  {
+    float heat = (float)i / RENDER_DENSITY_MAX;
+    prep->densityPalette[i] =
+        (Color){150 + 105 * heat, 220 * heat * heat, 40 * heat,
+                110 + 140 * heat};
+  }
+
+  return prep;
+}
+
+int getRenderCellX(RenderPrep *prep, float x)
+{
+  int cellX = (int)floorf((x - prep->origin.x) / prep->cellSize);
+  if (cellX < 0)
+    return 0;
+  if (cellX >= prep->gridColumns)
+    return prep->gridColumns - 1;
+  return cellX;
+}
+
+int getRenderCellY(RenderPrep *prep, float y)
+{
+  int cellY = (int)floorf((y - prep->origin.y) / prep->cellSize);
+  if (cellY < 0)
+    return 0;
+  if (cellY >= prep->gridRows)
+    return prep->gridRows - 1;
+  return cellY;
+}
+
+int getRenderBucket(RenderPrep *prep, RenderSprite *sprite)
+{
+  int cellX = getRenderCellX(prep, sprite->rect.x + sprite->rect.width / 2);
+  int cellY = getRenderCellY(prep, sprite->rect.y + sprite->rect.height / 2);
+
+  return (sprite->layer * prep->gridRows + cellY) * prep->gridColumns + cellX;
+}
+
+void addRenderSprite(RenderPrep *prep, Rectangle rect, int layer, int index,
+                     int flipDir)
+{
+  if (prep->spriteCount == prep->maxSprites)
+    return;
+
+  prep->unsorted[prep->spriteCount++] =
+      (RenderSprite){rect, layer, index, flipDir};
+
+  float halfExtent = fmaxf(rect.width, rect.height) / 2;
+  if (halfExtent > prep->margin)
+    prep->margin = halfExtent;
+}
+
+// Adds every live entity of an archetype as a sprite, offset by anchor times
+// its size
+void addArchetypeSprites(RenderPrep *prep, EntityArchetype *archetype,
+                         int layer, float anchor)
+{
+  for (int i = 0; i < archetype->liveCount; i++)
+  {
+    int slot = archetype->live[i];
+    Vector2 position = archetype->positions[slot];
+    Vector2 size = archetype->sizes[slot];
+
+    addRenderSprite(prep,
+                    (Rectangle){position.x - size.x * anchor,
+                                position.y - size.y * anchor, size.x, size.y},
+                    layer, slot, 1);
+  }
+}
+
+// Lays the heat map over the zoomed out views around every player, with a
+// cell to spare on each side. Cells are whole multiples of their size, so
+// the map doesn't shimmer as the players move.
+void placeDensityWindow(RenderPrep *prep, Vector2 halfExtent, int playerCount)
+{
+  prep->densityColumns = 0;
+  prep->densityRows = 0;
+  if (halfExtent.x <= 0 || halfExtent.y <= 0)
+    return;
+
+  Vector2 min = prep->playerPositions[0], max = prep->playerPositions[0];
+  for (int i = 1; i < playerCount; i++)
+  {
+    min.x = fminf(min.x, prep->playerPositions[i].x);
+    min.y = fminf(min.y, prep->playerPositions[i].y);
+    max.x = fmaxf(max.x, prep->playerPositions[i].x);
+    max.y = fmaxf(max.y, prep->playerPositions[i].y);
+  }
+  min = (Vector2){min.x - halfExtent.x, min.y - halfExtent.y};
+  max = (Vector2){max.x + halfExtent.x, max.y + halfExtent.y};
+
+  float span = fmaxf(max.x - min.x, max.y - min.y);
+  float cellSize = RENDER_DENSITY_CELL_SIZE;
+  while (span / cellSize > RENDER_DENSITY_TEXTURE_SIZE - 3)
+    cellSize *= 2;
+
+  int minX = (int)floorf(min.x / cellSize) - 1;
+  int minY = (int)floorf(min.y / cellSize) - 1;
+  prep->densityOrigin = (Vector2){minX * cellSize, minY * cellSize};
+  prep->densityCellSize = cellSize;
+  prep->densityColumns = (int)floorf(max.x / cellSize) + 2 - minX;
+  prep->densityRows = (int)floorf(max.y / cellSize) + 2 - minY;
+}
+
+// Counts the enemies in each density cell and turns the counts into heat
+// map pixels, so zoomed out viewports draw one quad instead of every sprite.
+// Heat is per smallest cell, so bigger cells don't all read as packed.
+void fillEnemyDensity(RenderPrep *prep, EntityArchetype *enemies)
+{
+  int cellCount = prep->densityColumns * prep->densityRows;
+  if (cellCount == 0)
+    return;
+
+  memset(prep->densityCounts, 0, cellCount * sizeof(unsigned short));
+
+  for (int i = 0; i < enemies->liveCount; i++)
+  {
+    Vector2 position = enemies->positions[enemies->live[i]];
+    int cellX = (int)floorf((position.x - prep->densityOrigin.x) /
+                            prep->densityCellSize);
+    int cellY = (int)floorf((position.y - prep->densityOrigin.y) /
+                            prep->densityCellSize);
+
+    if (cellX < 0 || cellY < 0 || cellX >= prep->densityColumns ||
+        cellY >= prep->densityRows)
+      continue;
+
+    unsigned short *count =
+        &prep->densityCounts[cellY * prep->densityColumns + cellX];
+    if (*count < USHRT_MAX)
+      (*count)++;
+  }
+
+  int scale = (int)(prep->densityCellSize / RENDER_DENSITY_CELL_SIZE);
+  int area = scale * scale;
+
+  for (int i = 0; i < cellCount; i++)
+  {
+    int heat = (prep->densityCounts[i] + area - 1) / area;
+    if (heat > RENDER_DENSITY_MAX)
+      heat = RENDER_DENSITY_MAX;
+    prep->densityPixels[i] = prep->densityPalette[heat];
+  }
+}
+
+// Collects every drawable entity once per frame and bins it by layer and
+// cell, so viewports never walk the entity arrays themselves
+void prepareRenderFrame(Game *game, RenderPrep *prep)
+{
+  prep->spriteCount = 0;
+  prep->margin = 0;
+  prep->inputTime = game->inputTime;
+
+  addArchetypeSprites(prep, &game->solarChargers, RENDER_LAYER_CHARGER, 0.5);
+  addArchetypeSprites(prep, &game->solarCells, RENDER_LAYER_CELL, 0.5);
+
+  // Snapshot player positions once instead of locking per viewport
+  Vector2 *playerPositions = prep->playerPositions;
+  float closestDistances[MAX_PLAYERS];
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Player *player = &game->players[i];
+
+    lockTracedMutex(&player->mutex, "player");
+    playerPositions[i] = player->position;
+    addRenderSprite(prep,
+                    (Rectangle){player->position.x - (float)player->size / 2,
+                                player->position.y - (float)player->size / 2,
+                                player->size, player->size},
+                    RENDER_LAYER_PLAYER, i, player->flipDir);
+    pthread_mutex_unlock(&player->mutex);
+
+    closestDistances[i] = INT_MAX;
+    prep->aimTargets[i] = -1;
+  }
+
+  EntityArchetype *enemies = &game->enemies;
+  addArchetypeSprites(prep, enemies, RENDER_LAYER_ENEMY, 0.5);
+  placeDensityWindow(prep, game->densityHalfExtent, game->playerCount);
+  fillEnemyDensity(prep, enemies);
+  addArchetypeSprites(prep, &game->projectiles, RENDER_LAYER_PROJECTILE, 0.5);
+
+  // Aim lines for every player
+  for (int i = 0; i < enemies->liveCount; i++)
+  {
+    int slot = enemies->live[i];
+    Vector2 position = enemies->positions[slot];
+
+    for (int j = 0; j < game->playerCount; j++)
+    {
+      float distance = getDistanceBetweenVectors(position, playerPositions[j]);
+
+      if (distance < closestDistances[j])
+      {
+        closestDistances[j] = distance;
+        prep->aimTargets[j] = slot;
+        prep->aimTargetPositions[j] = position;
+      }
+    }
+  }
+
+  for (int j = 0; j < game->playerCount; j++)
+  {
+    if (closestDistances[j] > game->gunRange)
+      prep->aimTargets[j] = -1;
+  }
+
+  // Counting sort by (layer, cell)
+  int bucketCount = RENDER_LAYER_COUNT * prep->gridColumns * prep->gridRows;
+  memset(prep->bucketStarts, 0, (bucketCount + 1) * sizeof(int));
+
+  for (int i = 0; i < prep->spriteCount; i++)
+  {
+    prep->bucketStarts[getRenderBucket(prep, &prep->unsorted[i]) + 1]++;
+  }
+
+  for (int i = 0; i < bucketCount; i++)
+  {
+    prep->bucketStarts[i + 1] += prep->bucketStarts[i];
+  }
+
+  // Scatter using the start offsets, then shift them back into place
+  for (int i = 0; i < prep->spriteCount; i++)
+  {
+    int bucket = getRenderBucket(prep, &prep->unsorted[i]);
+    prep->sprites[prep->bucketStarts[bucket]++] = prep->unsorted[i];
+  }
+
+  for (int i = bucketCount; i > 0; i--)
+  {
+    prep->bucketStarts[i] = prep->bucketStarts[i - 1];
+  }
+  prep->bucketStarts[0] = 0;
+}
+
+// Range of cells (inclusive) that can hold sprites visible to the camera
+void getVisibleRenderCells(RenderPrep *prep, Camera2D camera, int width,
+                           int height, int *minX, int *minY, int *maxX,
+                           int *maxY)
+{
+  Vector2 topLeft = GetScreenToWorld2D((Vector2){0, 0}, camera);
+  Vector2 bottomRight = GetScreenToWorld2D((Vector2){width, height}, camera);
+
+  *minX = getRenderCellX(prep, topLeft.x - prep->margin);
+  *minY = getRenderCellY(prep, topLeft.y - prep->margin);
+  *maxX = getRenderCellX(prep, bottomRight.x + prep->margin);
+  *maxY = getRenderCellY(prep, bottomRight.y + prep->margin);
+}
+
+RenderSprite *getRenderCellSprites(RenderPrep *prep, int layer, int cellX,
+                                   int cellY, int *count)
+{
+  int bucket = (layer * prep->gridRows + cellY) * prep->gridColumns + cellX;
+
+  *count = prep->bucketStarts[bucket + 1] - prep->bucketStarts[bucket];
+  return &prep->sprites[prep->bucketStarts[bucket]];
+}
+
+void pushRenderRect(RenderPrep *prep, Rectangle rect, Color color)
+{
+  if (prep->commandCount == MAX_RENDER_COMMANDS)
+    return;
+
+  RenderCommand *command = &prep->commands[prep->commandCount++];
+  command->type = RENDER_COMMAND_RECT;
+  command->rect = rect;
+  command->color = color;
+}
+
+void pushRenderText(RenderPrep *prep, const char *text, float x, float y,
+                    int fontSize, Color color, bool centered)
+{
+  if (prep->commandCount == MAX_RENDER_COMMANDS)
+    return;
+
+  RenderCommand *command = &prep->commands[prep->commandCount++];
+  command->type = RENDER_COMMAND_TEXT;
+  command->rect = (Rectangle){x, y, 0, 0};
+  command->color = color;
+  command->fontSize = fontSize;
+  command->centered = centered;
+  snprintf(command->text, sizeof(command->text), "%s", text);
+}
+
+// Replays the recorded overlays, main thread only
+void submitRenderCommands(RenderPrep *prep)
+{
+  for (int i = 0; i < prep->commandCount; i++)
+  {
+    RenderCommand *command = &prep->commands[i];
+
+    switch (command->type)
+    {
+    case RENDER_COMMAND_RECT:
+      DrawRectangleRec(command->rect, command->color);
+      break;
+
+    case RENDER_COMMAND_TEXT:
+    {
+      int x = command->rect.x;
+      if (command->centered)
+        x -= MeasureText(command->text, command->fontSize) / 2;
+
+      DrawText(command->text, x, command->rect.y, command->fontSize,
+               command->color);
+      break;
+    }
+    }
+  }
+}
+
+void destroyRenderPrep(RenderPrep *prep)
+{
+  trackedFree(prep->sprites);
+  trackedFree(prep->unsorted);
+  trackedFree(prep->bucketStarts);
+  trackedFree(prep->densityCounts);
+  trackedFree(prep->densityPixels);
+  trackedFree(prep);
+}
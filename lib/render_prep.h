@@ -0,0 +1,21 @@
+#include "render_prep.c"
+
+RenderPrep *createRenderPrep(Game *game, float cellSize);
+
+void prepareRenderFrame(Game *game, RenderPrep *prep);
+
+void getVisibleRenderCells(RenderPrep *prep, Camera2D camera, int width,
+                           int height, int *minX, int *minY, int *maxX,
+                           int *maxY);
+
+RenderSprite *getRenderCellSprites(RenderPrep *prep, int layer, int cellX,
+                                   int cellY, int *count);
+
+void pushRenderRect(RenderPrep *prep, Rectangle rect, Color color);
+
+void pushRenderText(RenderPrep *prep, const char *text, float x, float y,
+                    int fontSize, Color color, bool centered);
+
+void submitRenderCommands(RenderPrep *prep);
+
+void destroyRenderPrep(RenderPrep *prep);
@@ -0,0 +1,187 @@
+#include <math.h>
+#include <raylib.h>
+#include <rlgl.h>
+
+// Weight of the newest sample in the smoothed timings
+#define RESOLUTION_TIMING_SMOOTHING 0.1f
+
+void initResolutionScaler(ResolutionScaler *scaler, float targetFrameTime)
+{
+  scaler->enabled = true;
+  scaler->targetFrameTime = targetFrameTime;
+  scaler->minScale = 0.5;
+  scaler->maxScale = 1.0;
+  scaler->scaleStep = 0.1;
+  scaler->downscaleSamples = 3;
+  scaler->upscaleSamples = 15;
+  scaler->upscaleHeadroom = 0.7;
+  scaler->cpuTime = 0;
+  scaler->compositeTime = 0;
+  scaler->gpuTimingFrames = 4;
+  scaler->framesUntilGpuTiming = 0;
+  scaler->gpuSampled = false;
+  scaler->missedFrame = false;
+}
+
+float smoothTiming(float smoothed, float sample)
+{
+  return smoothed + (sample - smoothed) * RESOLUTION_TIMING_SMOOTHING;
+}
+
+void recordCpuTime(ResolutionScaler *scaler, float seconds)
+{
+  scaler->cpuTime = smoothTiming(scaler->cpuTime, seconds);
+}
+
+void recordCompositeTime(ResolutionScaler *scaler, float seconds)
+{
+  scaler->compositeTime = smoothTiming(scaler->compositeTime, seconds);
+}
+
+// A viewport without a timing yet, or just resized, starts from its first
+void recordViewportRenderTime(Viewport *viewport, float seconds)
+{
+  if (viewport->renderTime == 0)
+    viewport->renderTime = seconds;
+  else
+    viewport->renderTime = smoothTiming(viewport->renderTime, seconds);
+}
+
+// Whether this frame's viewport renders are timed, called once per frame
+bool isGpuTimingFrame(ResolutionScaler *scaler)
+{
+  if (!scaler->enabled)
+    return false;
+
+  if (scaler->framesUntilGpuTiming > 0)
+  {
+    scaler->framesUntilGpuTiming--;
+    return false;
+  }
+
+  scaler->framesUntilGpuTiming = scaler->gpuTimingFrames - 1;
+  scaler->gpuSampled = true;
+  return true;
+}
+
+// Blocks until the GPU has drawn everything submitted to the current render
+// target. rlgl has no glFinish, but a pixel can't be read back before the
+// draws writing it are done.
+void waitForGpu(void)
+{
+  rlDrawRenderBatchActive();
+  MemFree(rlReadScreenPixels(1, 1));
+}
+
+// Reallocates the viewport's render texture at the given fraction of its
+// on-screen size. Must be called outside of BeginDrawing/EndDrawing.
+void setViewportResolutionScale(Viewport *viewport, float scale)
+{
+  int width = (int)(viewport->screenRect.width * scale);
+  int height = (int)(viewport->screenRect.height * scale);
+
+  if (viewport->renderTexture->id != 0)
+  {
+    if (viewport->renderTexture->texture.width == width &&
+        viewport->renderTexture->texture.height == height)
+    {
+      viewport->resolutionScale = scale;
+      return;
+    }
+
+    UnloadRenderTexture(*viewport->renderTexture);
+  }
+
+  *viewport->renderTexture = LoadRenderTexture(width, height);
+  SetTextureFilter(viewport->renderTexture->texture,
+                   scale < 1 ? TEXTURE_FILTER_BILINEAR : TEXTURE_FILTER_POINT);
+
+  viewport->resolutionScale = scale;
+  viewport->renderTime = 0; // timings at the old size no longer apply
+  viewport->overBudgetSamples = 0;
+  viewport->underBudgetSamples = 0;
+}
+
+// Moves each viewport's resolution towards what fits in its share of the
+// frame budget. frameTime is the full frame period, including vsync waits.
+// Only frames with a fresh GPU timing count towards rescaling.
+void updateResolutionScaling(Game *game, float frameTime)
+{
+  ResolutionScaler *scaler = &game->resolution;
+  if (!scaler->enabled)
+    return;
+
+  // A timed frame is late by its own stalls, so misses are only taken from
+  // the frames in between
+  if (!scaler->gpuSampled)
+  {
+    if (frameTime > scaler->targetFrameTime * 1.1f)
+      scaler->missedFrame = true;
+    return;
+  }
+
+  bool missedFrame = scaler->missedFrame;
+  scaler->gpuSampled = false;
+  scaler->missedFrame = false;
+
+  // A smaller render texture can't win back time the simulation alone
+  // already overspends, so hold the resolution until the CPU catches up
+  if (scaler->cpuTime > scaler->targetFrameTime)
+  {
+    for (int i = 0; i < game->viewportCount; i++)
+    {
+      game->viewports[i].overBudgetSamples = 0;
+      game->viewports[i].underBudgetSamples = 0;
+    }
+    return;
+  }
+
+  // Whatever the simulation and composite leave is split between viewports
+  float renderBudget = (scaler->targetFrameTime - scaler->cpuTime -
+                        scaler->compositeTime) /
+                       game->viewportCount;
+
+  for (int i = 0; i < game->viewportCount; i++)
+  {
+    Viewport *viewport = &game->viewports[i];
+
+    if (missedFrame || viewport->renderTime > renderBudget)
+    {
+      viewport->overBudgetSamples++;
+      viewport->underBudgetSamples = 0;
+    }
+    else if (viewport->renderTime < renderBudget * scaler->upscaleHeadroom)
+    {
+      viewport->underBudgetSamples++;
+      viewport->overBudgetSamples = 0;
+    }
+    else
+    {
+      viewport->overBudgetSamples = 0;
+      viewport->underBudgetSamples = 0;
+    }
+
+    float scale = viewport->resolutionScale;
+
+    if (viewport->overBudgetSamples >= scaler->downscaleSamples)
+    {
+      scale = fmaxf(scaler->minScale, scale - scaler->scaleStep);
+    }
+    else if (viewport->underBudgetSamples >= scaler->upscaleSamples)
+    {
+      scale = fminf(scaler->maxScale, scale + scaler->scaleStep);
+    }
+
+    if (scale != viewport->resolutionScale)
+    {
+      setViewportResolutionScale(viewport, scale);
+    }
+    else if (viewport->overBudgetSamples >= scaler->downscaleSamples ||
+             viewport->underBudgetSamples >= scaler->upscaleSamples)
+    {
+      // Already at a bound, start counting again
+      viewport->overBudgetSamples = 0;
+      viewport->underBudgetSamples = 0;
+    }
+  }
+}
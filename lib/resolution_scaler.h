@@ -0,0 +1,17 @@
+#include "resolution_scaler.c"
+
+void initResolutionScaler(ResolutionScaler *scaler, float targetFrameTime);
+
+void recordCpuTime(ResolutionScaler *scaler, float seconds);
+
+void recordCompositeTime(ResolutionScaler *scaler, float seconds);
+
+void recordViewportRenderTime(Viewport *viewport, float seconds);
+
+bool isGpuTimingFrame(ResolutionScaler *scaler);
+
+void waitForGpu(void);
+
+void setViewportResolutionScale(Viewport *viewport, float scale);
+
+void updateResolutionScaling(Game *game, float frameTime);
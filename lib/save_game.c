@@ -0,0 +1,698 @@
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAVE_MAGIC 0x56535754 // "TWSV"
+#define SAVE_VERSION 1
+#define SAVE_BYTE_ORDER 0x01020304 // reads back differently on other endians
+
+// Blocks start 16 byte aligned so a mapped save can be copied from directly
+#define SAVE_ALIGNMENT 16
+
+#define AUTOSAVE_SECONDS 30
+
+// Enemies, projectiles, solar cells and chargers
+#define SAVE_ARCHETYPE_COUNT 4
+// live, liveIndex, then every column but sounds, which are runtime handles
+#define SAVE_COLUMN_COUNT 9
+
+// Snapshot copies are split into pieces this big to run as parallel jobs
+#define SAVE_COPY_PIECE (1 << 20)
+
+// Where a block of the file lives, [offset, offset + size)
+typedef struct
+{
+  uint64_t offset;
+  uint64_t size;
+} SaveBlock;
+
+// On-disk header, every block it names follows it in the file
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t headerSize;
+  uint64_t fileSize;
+
+  // What the simulation was sized with
+  int32_t playerCount;
+  int32_t mapSize;
+  int32_t capacities[SAVE_ARCHETYPE_COUNT];
+
+  int32_t frameCount;
+  int32_t lastWaveFrame;
+  int32_t currentWave;
+  int32_t enemyCount;
+  int32_t enemiesKilled;
+  int32_t solarCellsCollected;
+  uint32_t randomState;
+  float battery;
+  int32_t gameOver;
+  int32_t gameWon;
+
+  int32_t spawnPending;
+  int32_t spawnTicksLeft;
+  int32_t spawnCursor;
+
+  uint32_t worldSeed;
+  int32_t chunkCount;
+  int32_t activeChunkCount;
+
+  int32_t liveCounts[SAVE_ARCHETYPE_COUNT];
+
+  SaveBlock players;
+  SaveBlock columns[SAVE_ARCHETYPE_COUNT][SAVE_COLUMN_COUNT];
+  SaveBlock chunks;
+  SaveBlock activeChunks;
+  SaveBlock chunkData;
+} SaveHeader;
+
+typedef struct
+{
+  Vector2 position;
+  int32_t flipDir;
+  float health;
+} SavedPlayer;
+
+typedef struct
+{
+  int32_t state;
+  uint32_t randomState;
+  int32_t cellCount;
+  int32_t enemyCount;
+  uint64_t dataOffset; // into the chunk data block
+} SavedChunk;
+
+typedef struct
+{
+  void *to;
+  const void *from;
+  size_t size;
+} SaveCopy;
+
+typedef struct
+{
+  SaveCopy copies[SAVE_ARCHETYPE_COUNT * SAVE_COLUMN_COUNT];
+  int copyCount;
+  size_t totalSize;
+} SaveCopyList;
+
+void getSaveArchetypes(Game *game, EntityArchetype **archetypes)
+{
+  archetypes[0] = &game->enemies;
+  archetypes[1] = &game->projectiles;
+  archetypes[2] = &game->solarCells;
+  archetypes[3] = &game->solarChargers;
+}
+
+// Columns the archetype doesn't have come back NULL with a size of 0
+void getSaveColumns(EntityArchetype *archetype, void **columns, size_t *sizes)
+{
+  columns[0] = archetype->live;
+  sizes[0] = sizeof(int);
+  columns[1] = archetype->liveIndex;
+  sizes[1] = sizeof(int);
+  columns[2] = archetype->positions;
+  sizes[2] = sizeof(Vector2);
+  columns[3] = archetype->sizes;
+  sizes[3] = sizeof(Vector2);
+  columns[4] = archetype->speeds;
+  sizes[4] = sizeof(int);
+  columns[5] = archetype->damages;
+  sizes[5] = sizeof(float);
+  columns[6] = archetype->velocities;
+  sizes[6] = sizeof(Vector2);
+  columns[7] = archetype->lifetimes;
+  sizes[7] = sizeof(int);
+  columns[8] = archetype->owners;
+  sizes[8] = sizeof(int);
+
+  for (int i = 0; i < SAVE_COLUMN_COUNT; i++)
+  {
+    sizes[i] = columns[i] != NULL ? sizes[i] * archetype->capacity : 0;
+  }
+}
+
+SaveBlock addSaveBlock(uint64_t *fileSize, uint64_t size)
+{
+  SaveBlock block = {*fileSize, size};
+  *fileSize += (size + SAVE_ALIGNMENT - 1) / SAVE_ALIGNMENT * SAVE_ALIGNMENT;
+  return block;
+}
+
+void copySaveBlocksJob(void *data, int index)
+{
+  SaveCopyList *list = (SaveCopyList *)data;
+  size_t start = (size_t)index * SAVE_COPY_PIECE;
+  size_t end = start + SAVE_COPY_PIECE;
+  size_t copyStart = 0;
+
+  for (int i = 0; i < list->copyCount && copyStart < end; i++)
+  {
+    SaveCopy *copy = &list->copies[i];
+    size_t copyEnd = copyStart + copy->size;
+
+    size_t from = start > copyStart ? start : copyStart;
+    size_t to = end < copyEnd ? end : copyEnd;
+    if (from < to)
+      memcpy((char *)copy->to + (from - copyStart),
+             (const char *)copy->from + (from - copyStart), to - from);
+
+    copyStart = copyEnd;
+  }
+}
+
+void *writeSaveFiles(void *arg);
+
+SaveWriter *createSaveWriter(const char *path)
+{
+  SaveWriter *writer = trackedCalloc(MEMORY_SAVES, 1, sizeof(SaveWriter));
+  snprintf(writer->path, sizeof(writer->path), "%s", path);
+
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->wake, NULL);
+  pthread_create(&writer->thread, NULL, writeSaveFiles, (void *)writer);
+
+  return writer;
+}
+
+// Writes to a temporary file and renames it over the old save once it is on
+// disk, so a crash mid-save leaves the last good one in place
+bool writeSaveImage(SaveWriter *writer)
+{
+  char tempPath[sizeof(writer->path) + 4];
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", writer->path);
+
+  int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+
+  size_t written = 0;
+  while (written < writer->imageSize)
+  {
+    ssize_t result =
+        write(fd, writer->image + written, writer->imageSize - written);
+    if (result < 0)
+    {
+      close(fd);
+      return false;
+    }
+    written += result;
+  }
+
+  if (fsync(fd) < 0)
+  {
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  if (rename(tempPath, writer->path) < 0)
+    return false;
+
+  // The rename itself only lasts once the directory is synced too
+  char directory[sizeof(writer->path)];
+  snprintf(directory, sizeof(directory), "%s", writer->path);
+  char *separator = strrchr(directory, '/');
+  if (separator != NULL)
+    *separator = '\0';
+  else
+    snprintf(directory, sizeof(directory), ".");
+
+  int directoryFd = open(directory, O_RDONLY);
+  if (directoryFd >= 0)
+  {
+    fsync(directoryFd);
+    close(directoryFd);
+  }
+
+  return true;
+}
+
+void *writeSaveFiles(void *arg)
+{
+  SaveWriter *writer = (SaveWriter *)arg;
+  setTraceThreadName("save writer");
+
+  pthread_mutex_lock(&writer->mutex);
+  while (true)
+  {
+    while (!writer->busy && !writer->stopping)
+      pthread_cond_wait(&writer->wake, &writer->mutex);
+
+    if (!writer->busy)
+      break;
+    pthread_mutex_unlock(&writer->mutex);
+
+    // Only this thread touches the image while busy
+    beginTraceSpan("write save");
+    if (writeSaveImage(writer))
+      writer->savesWritten++;
+    else
+      printf("ERROR: Could not write save %s\n", writer->path);
+    endTraceSpan();
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->busy = false;
+    pthread_cond_broadcast(&writer->wake);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+
+  return NULL;
+}
+
+// Copies the game into the writer's image and hands it to the writer
+// thread. Call between ticks. Returns false without waiting if the last
+// save is still being written.
+bool snapshotGame(SaveWriter *writer, Game *game)
+{
+  pthread_mutex_lock(&writer->mutex);
+  bool busy = writer->busy;
+  pthread_mutex_unlock(&writer->mutex);
+  if (busy)
+    return false;
+
+  EntityArchetype *archetypes[SAVE_ARCHETYPE_COUNT];
+  getSaveArchetypes(game, archetypes);
+  World *world = &game->world;
+  int chunkCount = world->columns * world->rows;
+
+  // Lay the file out first so the image is only grown, never copied twice
+  SaveHeader header = {0};
+  uint64_t fileSize = 0;
+  addSaveBlock(&fileSize, sizeof(SaveHeader));
+  header.players =
+      addSaveBlock(&fileSize, game->playerCount * sizeof(SavedPlayer));
+
+  SaveCopyList list = {0};
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT; i++)
+  {
+    void *columns[SAVE_COLUMN_COUNT];
+    size_t sizes[SAVE_COLUMN_COUNT];
+    getSaveColumns(archetypes[i], columns, sizes);
+
+    for (int j = 0; j < SAVE_COLUMN_COUNT; j++)
+    {
+      header.columns[i][j] = addSaveBlock(&fileSize, sizes[j]);
+      if (sizes[j] > 0)
+      {
+        list.copies[list.copyCount++] = (SaveCopy){NULL, columns[j], sizes[j]};
+        list.totalSize += sizes[j];
+      }
+    }
+  }
+
+  header.chunks = addSaveBlock(&fileSize, chunkCount * sizeof(SavedChunk));
+  header.activeChunks =
+      addSaveBlock(&fileSize, world->activeCount * sizeof(int));
+  header.chunkData = addSaveBlock(&fileSize, world->storedBytes);
+
+  if (fileSize > writer->imageCapacity)
+  {
+    trackedFree(writer->image);
+    writer->image = trackedCalloc(MEMORY_SAVES, 1, fileSize);
+    writer->imageCapacity = fileSize;
+  }
+  unsigned char *image = writer->image;
+  writer->imageSize = fileSize;
+
+  header.magic = SAVE_MAGIC;
+  header.version = SAVE_VERSION;
+  header.byteOrder = SAVE_BYTE_ORDER;
+  header.headerSize = sizeof(SaveHeader);
+  header.fileSize = fileSize;
+
+  header.playerCount = game->playerCount;
+  header.mapSize = game->mapSize;
+  header.frameCount = game->frameCount;
+  header.lastWaveFrame = game->lastWaveFrame;
+  header.currentWave = game->currentWave;
+  header.enemyCount = game->enemyCount;
+  header.enemiesKilled = game->enemiesKilled;
+  header.solarCellsCollected = game->solarCellsCollected;
+  header.randomState = game->randomState;
+  header.battery = game->battery;
+  header.gameOver = game->gameOver;
+  header.gameWon = game->gameWon;
+  header.spawnPending = game->spawner.pending;
+  header.spawnTicksLeft = game->spawner.ticksLeft;
+  header.spawnCursor = game->spawner.cursor;
+  header.worldSeed = world->seed;
+  header.chunkCount = chunkCount;
+  header.activeChunkCount = world->activeCount;
+
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT; i++)
+  {
+    header.capacities[i] = archetypes[i]->capacity;
+    header.liveCounts[i] = archetypes[i]->liveCount;
+  }
+  memcpy(image, &header, sizeof(SaveHeader));
+
+  SavedPlayer *players = (SavedPlayer *)(image + header.players.offset);
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    players[i] = (SavedPlayer){game->players[i].position,
+                               game->players[i].flipDir,
+                               game->players[i].health};
+  }
+
+  // The columns are the bulk of it, copy them on every core
+  int copy = 0;
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT; i++)
+  {
+    for (int j = 0; j < SAVE_COLUMN_COUNT; j++)
+    {
+      if (header.columns[i][j].size > 0)
+        list.copies[copy++].to = image + header.columns[i][j].offset;
+    }
+  }
+
+  int pieces = (list.totalSize + SAVE_COPY_PIECE - 1) / SAVE_COPY_PIECE;
+  if (game->jobs != NULL)
+  {
+    runJob(game->jobs, "copy save", copySaveBlocksJob, &list, pieces);
+  }
+  else
+  {
+    for (int i = 0; i < pieces; i++)
+    {
+      copySaveBlocksJob(&list, i);
+    }
+  }
+
+  SavedChunk *chunks = (SavedChunk *)(image + header.chunks.offset);
+  unsigned char *chunkData = image + header.chunkData.offset;
+  uint64_t dataOffset = 0;
+  for (int i = 0; i < chunkCount; i++)
+  {
+    WorldChunk *chunk = &world->chunks[i];
+    chunks[i] = (SavedChunk){chunk->state, chunk->randomState,
+                             chunk->cellCount, chunk->enemyCount, dataOffset};
+
+    if (chunk->data != NULL)
+    {
+      size_t size =
+          (chunk->cellCount + chunk->enemyCount) * 2 * sizeof(uint16_t);
+      memcpy(chunkData + dataOffset, chunk->data, size);
+      dataOffset += size;
+    }
+  }
+  memcpy(image + header.activeChunks.offset, world->activeChunks,
+         world->activeCount * sizeof(int));
+
+  pthread_mutex_lock(&writer->mutex);
+  writer->busy = true;
+  pthread_cond_broadcast(&writer->wake);
+  pthread_mutex_unlock(&writer->mutex);
+
+  return true;
+}
+
+void waitForSaveWriter(SaveWriter *writer)
+{
+  pthread_mutex_lock(&writer->mutex);
+  while (writer->busy)
+    pthread_cond_wait(&writer->wake, &writer->mutex);
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+// Snapshots every AUTOSAVE_SECONDS of game time, at a tick boundary
+void autosaveGame(Game *game)
+{
+  if (game->saver == NULL ||
+      game->frameCount % (game->targetFPS * AUTOSAVE_SECONDS) != 0)
+    return;
+
+  snapshotGame(game->saver, game);
+}
+
+// Finishes the save in progress, if any
+void destroySaveWriter(SaveWriter *writer)
+{
+  pthread_mutex_lock(&writer->mutex);
+  writer->stopping = true;
+  pthread_cond_broadcast(&writer->wake);
+  pthread_mutex_unlock(&writer->mutex);
+
+  pthread_join(writer->thread, NULL);
+
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->wake);
+  trackedFree(writer->image);
+  trackedFree(writer);
+}
+
+bool isSaveBlockValid(SaveBlock block, uint64_t fileSize, uint64_t size)
+{
+  return block.size == size && block.offset <= fileSize &&
+         block.size <= fileSize - block.offset;
+}
+
+// live has to be a permutation of the slots with liveIndex its inverse, or
+// walking the live entities would index past the columns. Checking the
+// inverse is enough, as it can't hold if two entries share a slot.
+bool isSavedLiveListValid(const int *live, const int *liveIndex, int capacity)
+{
+  for (int i = 0; i < capacity; i++)
+  {
+    if (live[i] < 0 || live[i] >= capacity || liveIndex[live[i]] != i)
+      return false;
+  }
+
+  return true;
+}
+
+// Replaces an initialized simulation with the one in the save, resizing it
+// first if the save was made with other limits. Columns are copied straight
+// out of the mapped file.
+bool loadGame(Game *game, const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    printf("ERROR: Could not open save %s\n", path);
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) < 0 || info.st_size < (off_t)sizeof(SaveHeader))
+  {
+    printf("ERROR: %s is not a save\n", path);
+    close(fd);
+    return false;
+  }
+
+  unsigned char *data =
+      mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    printf("ERROR: Could not map save %s\n", path);
+    return false;
+  }
+
+  SaveHeader *header = (SaveHeader *)data;
+  uint64_t fileSize = info.st_size;
+  bool valid = header->magic == SAVE_MAGIC &&
+               header->version == SAVE_VERSION &&
+               header->byteOrder == SAVE_BYTE_ORDER &&
+               header->headerSize == sizeof(SaveHeader) &&
+               header->fileSize == fileSize && header->playerCount > 0 &&
+               header->playerCount <= MAX_PLAYERS && header->mapSize > 0;
+
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT && valid; i++)
+  {
+    valid = header->capacities[i] > 0 && header->liveCounts[i] >= 0 &&
+            header->liveCounts[i] <= header->capacities[i];
+  }
+
+  if (!valid)
+  {
+    printf("ERROR: %s is not a save from this version\n", path);
+    munmap(data, info.st_size);
+    return false;
+  }
+
+  EntityArchetype *archetypes[SAVE_ARCHETYPE_COUNT];
+  getSaveArchetypes(game, archetypes);
+  int chunkColumns =
+      (int)ceilf((float)header->mapSize / game->world.chunkSize);
+  int chunkCount = chunkColumns * chunkColumns;
+
+  valid = header->chunkCount == chunkCount &&
+          header->activeChunkCount >= 0 &&
+          header->activeChunkCount <= chunkCount &&
+          isSaveBlockValid(header->players, fileSize,
+                           header->playerCount * sizeof(SavedPlayer)) &&
+          isSaveBlockValid(header->chunks, fileSize,
+                           chunkCount * sizeof(SavedChunk)) &&
+          isSaveBlockValid(header->activeChunks, fileSize,
+                           header->activeChunkCount * sizeof(int)) &&
+          isSaveBlockValid(header->chunkData, fileSize,
+                           header->chunkData.size);
+
+  // Archetypes keep their components whatever their size
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT && valid; i++)
+  {
+    void *columns[SAVE_COLUMN_COUNT];
+    size_t sizes[SAVE_COLUMN_COUNT];
+    getSaveColumns(archetypes[i], columns, sizes);
+
+    for (int j = 0; j < SAVE_COLUMN_COUNT && valid; j++)
+    {
+      valid = isSaveBlockValid(header->columns[i][j], fileSize,
+                               sizes[j] / archetypes[i]->capacity *
+                                   header->capacities[i]);
+    }
+  }
+
+  SavedChunk *chunks = (SavedChunk *)(data + header->chunks.offset);
+  for (int i = 0; i < chunkCount && valid; i++)
+  {
+    uint64_t size =
+        (uint64_t)(chunks[i].cellCount + chunks[i].enemyCount) * 2 *
+        sizeof(uint16_t);
+    valid = chunks[i].state >= WORLD_CHUNK_UNLOADED &&
+            chunks[i].state <= WORLD_CHUNK_EVICTED &&
+            chunks[i].cellCount >= 0 && chunks[i].enemyCount >= 0 &&
+            chunks[i].dataOffset <= header->chunkData.size &&
+            size <= header->chunkData.size - chunks[i].dataOffset;
+  }
+
+  int *activeChunks = (int *)(data + header->activeChunks.offset);
+  for (int i = 0; i < header->activeChunkCount && valid; i++)
+  {
+    valid = activeChunks[i] >= 0 && activeChunks[i] < chunkCount &&
+            chunks[activeChunks[i]].state == WORLD_CHUNK_ACTIVE;
+  }
+
+  // Columns 0 and 1 are live and liveIndex
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT && valid; i++)
+  {
+    valid = isSavedLiveListValid(
+        (int *)(data + header->columns[i][0].offset),
+        (int *)(data + header->columns[i][1].offset), header->capacities[i]);
+  }
+
+  if (!valid)
+  {
+    printf("ERROR: Save %s is damaged\n", path);
+    munmap(data, info.st_size);
+    return false;
+  }
+
+  // Size the simulation like the one that was saved
+  if (game->playerCount != header->playerCount ||
+      game->mapSize != header->mapSize ||
+      game->maxEnemies != header->capacities[0] ||
+      game->maxProjectiles != header->capacities[1] ||
+      game->maxSolarCells != header->capacities[2] ||
+      game->maxSolarChargers != header->capacities[3])
+  {
+    destroySimulation(game);
+    game->playerCount = header->playerCount;
+    game->mapSize = header->mapSize;
+    game->maxEnemies = header->capacities[0];
+    game->maxProjectiles = header->capacities[1];
+    game->maxSolarCells = header->capacities[2];
+    game->maxSolarChargers = header->capacities[3];
+    initializeSimulation(game);
+    getSaveArchetypes(game, archetypes);
+  }
+  World *world = &game->world;
+
+  for (int i = 0; i < SAVE_ARCHETYPE_COUNT; i++)
+  {
+    void *columns[SAVE_COLUMN_COUNT];
+    size_t sizes[SAVE_COLUMN_COUNT];
+    getSaveColumns(archetypes[i], columns, sizes);
+
+    for (int j = 0; j < SAVE_COLUMN_COUNT; j++)
+    {
+      if (sizes[j] > 0)
+        memcpy(columns[j], data + header->columns[i][j].offset, sizes[j]);
+    }
+    archetypes[i]->liveCount = header->liveCounts[i];
+  }
+
+  SavedPlayer *players = (SavedPlayer *)(data + header->players.offset);
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    game->players[i].position = players[i].position;
+    game->players[i].flipDir = players[i].flipDir;
+    game->players[i].health = players[i].health;
+  }
+
+  game->frameCount = header->frameCount;
+  game->lastWaveFrame = header->lastWaveFrame;
+  game->currentWave = header->currentWave;
+  game->enemyCount = header->enemyCount;
+  game->enemiesKilled = header->enemiesKilled;
+  game->solarCellsCollected = header->solarCellsCollected;
+  game->randomState = header->randomState;
+  game->battery = header->battery;
+  game->gameOver = header->gameOver;
+  game->gameWon = header->gameWon;
+  game->spawner.pending = header->spawnPending;
+  game->spawner.ticksLeft = header->spawnTicksLeft;
+  game->spawner.cursor = header->spawnCursor;
+
+  world->seed = header->worldSeed;
+  resetWorld(world);
+  unsigned char *chunkData = data + header->chunkData.offset;
+  for (int i = 0; i < chunkCount; i++)
+  {
+    WorldChunk *chunk = &world->chunks[i];
+    chunk->state = chunks[i].state;
+    chunk->randomState = chunks[i].randomState;
+
+    // Evicted chunks are already packed the way the world keeps them
+    size_t size = (chunks[i].cellCount + chunks[i].enemyCount) * 2 *
+                  sizeof(uint16_t);
+    if (chunk->state == WORLD_CHUNK_EVICTED && size > 0)
+    {
+      chunk->cellCount = chunks[i].cellCount;
+      chunk->enemyCount = chunks[i].enemyCount;
+      chunk->data = trackedMalloc(MEMORY_ENTITIES, size);
+      memcpy(chunk->data, chunkData + chunks[i].dataOffset, size);
+      world->storedBytes += size;
+    }
+  }
+  memcpy(world->activeChunks, activeChunks,
+         header->activeChunkCount * sizeof(int));
+  world->activeCount = header->activeChunkCount;
+
+  munmap(data, info.st_size);
+
+  // Grids only hold slots, rebuild them from the restored positions
+  clearSpatialGrid(&game->solarCellGrid);
+  for (int i = 0; i < game->solarCells.liveCount; i++)
+  {
+    int slot = game->solarCells.live[i];
+    insertGridEntry(&game->solarCellGrid, slot,
+                    game->solarCells.positions[slot]);
+  }
+  indexEnemies(game);
+  rebuildMinimapKind(&game->minimap, MINIMAP_ENEMY, &game->enemies);
+  rebuildMinimapKind(&game->minimap, MINIMAP_CELL, &game->solarCells);
+  rebuildMinimapKind(&game->minimap, MINIMAP_CHARGER, &game->solarChargers);
+  rebuildChargerTree(game);
+
+  // Tiers follow from where everyone is, so they aren't saved
+  for (int i = 0; i < game->enemies.liveCount; i++)
+  {
+    int slot = game->enemies.live[i];
+    game->enemyTiers[slot] = getEnemyTier(game, game->enemies.positions[slot]);
+  }
+
+  return true;
+}
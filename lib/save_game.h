@@ -0,0 +1,27 @@
+#include "save_game.c"
+
+void getSaveArchetypes(Game *game, EntityArchetype **archetypes);
+
+void getSaveColumns(EntityArchetype *archetype, void **columns, size_t *sizes);
+
+SaveBlock addSaveBlock(uint64_t *fileSize, uint64_t size);
+
+void copySaveBlocksJob(void *data, int index);
+
+void *writeSaveFiles(void *arg);
+
+SaveWriter *createSaveWriter(const char *path);
+
+bool writeSaveImage(SaveWriter *writer);
+
+bool snapshotGame(SaveWriter *writer, Game *game);
+
+void waitForSaveWriter(SaveWriter *writer);
+
+void autosaveGame(Game *game);
+
+void destroySaveWriter(SaveWriter *writer);
+
+bool isSaveBlockValid(SaveBlock block, uint64_t fileSize, uint64_t size);
+
+bool loadGame(Game *game, const char *path);
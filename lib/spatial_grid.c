@@ -0,0 +1,108 @@
+#include <math.h>
+#include <raylib.h>
+#include <stdlib.h>
+
+void clearSpatialGrid(SpatialGrid *grid)
+{
+  for (int i = 0; i < grid->columns * grid->rows; i++)
+  {
+    grid->heads[i] = -1;
+  }
+
+  for (int i = 0; i < grid->capacity; i++)
+  {
+    grid->gridCells[i] = -1;
+  }
+}
+
+// Covers the square [origin, origin + extent) with cellSize cells for up to
+// capacity entries. Entries outside it are filed under the nearest edge cell.
+void initializeSpatialGrid(SpatialGrid *grid, Vector2 origin, float extent,
+                           float cellSize, int capacity)
+{
+  grid->origin = origin;
+  grid->cellSize = cellSize;
+  grid->columns = (int)ceilf(extent / cellSize);
+  if (grid->columns < 1)
+    grid->columns = 1;
+  grid->rows = grid->columns;
+  grid->capacity = capacity;
+
+  grid->heads = trackedMalloc(MEMORY_ENTITIES,
+                              grid->columns * grid->rows * sizeof(int));
+  grid->next = trackedMalloc(MEMORY_ENTITIES, capacity * sizeof(int));
+  grid->prev = trackedMalloc(MEMORY_ENTITIES, capacity * sizeof(int));
+  grid->gridCells = trackedMalloc(MEMORY_ENTITIES, capacity * sizeof(int));
+
+  clearSpatialGrid(grid);
+}
+
+int getGridColumn(SpatialGrid *grid, float x)
+{
+  int column = (int)floorf((x - grid->origin.x) / grid->cellSize);
+  if (column < 0)
+    return 0;
+  if (column >= grid->columns)
+    return grid->columns - 1;
+  return column;
+}
+
+int getGridRow(SpatialGrid *grid, float y)
+{
+  int row = (int)floorf((y - grid->origin.y) / grid->cellSize);
+  if (row < 0)
+    return 0;
+  if (row >= grid->rows)
+    return grid->rows - 1;
+  return row;
+}
+
+// Files an entry under the cell its position falls in
+void insertGridEntry(SpatialGrid *grid, int entry, Vector2 position)
+{
+  int gridCell = getGridRow(grid, position.y) * grid->columns +
+                 getGridColumn(grid, position.x);
+
+  grid->gridCells[entry] = gridCell;
+  grid->prev[entry] = -1;
+  grid->next[entry] = grid->heads[gridCell];
+  if (grid->heads[gridCell] != -1)
+    grid->prev[grid->heads[gridCell]] = entry;
+  grid->heads[gridCell] = entry;
+}
+
+void removeGridEntry(SpatialGrid *grid, int entry)
+{
+  int gridCell = grid->gridCells[entry];
+  if (gridCell == -1)
+    return;
+
+  if (grid->prev[entry] != -1)
+    grid->next[grid->prev[entry]] = grid->next[entry];
+  else
+    grid->heads[gridCell] = grid->next[entry];
+
+  if (grid->next[entry] != -1)
+    grid->prev[grid->next[entry]] = grid->prev[entry];
+
+  grid->gridCells[entry] = -1;
+}
+
+// Range of grid cells holding entries whose centre is inside area. Callers
+// pad area by the largest entry's half size.
+void getGridCellRange(SpatialGrid *grid, Rectangle area, int *minColumn,
+                      int *minRow, int *maxColumn, int *maxRow)
+{
+  *minColumn = getGridColumn(grid, area.x);
+  *maxColumn = getGridColumn(grid, area.x + area.width);
+  *minRow = getGridRow(grid, area.y);
+  *maxRow = getGridRow(grid, area.y + area.height);
+}
+
+void destroySpatialGrid(SpatialGrid *grid)
+{
+  trackedFree(grid->heads);
+  trackedFree(grid->next);
+  trackedFree(grid->prev);
+  trackedFree(grid->gridCells);
+}
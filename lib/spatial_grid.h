@@ -0,0 +1,19 @@
+#include "spatial_grid.c"
+
+void clearSpatialGrid(SpatialGrid *grid);
+
+void initializeSpatialGrid(SpatialGrid *grid, Vector2 origin, float extent,
+                           float cellSize, int capacity);
+
+int getGridColumn(SpatialGrid *grid, float x);
+
+int getGridRow(SpatialGrid *grid, float y);
+
+void insertGridEntry(SpatialGrid *grid, int entry, Vector2 position);
+
+void removeGridEntry(SpatialGrid *grid, int entry);
+
+void getGridCellRange(SpatialGrid *grid, Rectangle area, int *minColumn,
+                      int *minRow, int *maxColumn, int *maxRow);
+
+void destroySpatialGrid(SpatialGrid *grid);
@@ -0,0 +1,240 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+// Shared by every thread in the process, like the memory tracker
+TraceRecorder traceRecorder = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+_Thread_local TraceBuffer *traceBuffer = NULL;
+_Thread_local char traceThreadName[32];
+
+// Open spans, a start of 0 means tracing was off when it began
+_Thread_local const char *traceSpanNames[TRACE_MAX_DEPTH];
+_Thread_local long long traceSpanStarts[TRACE_MAX_DEPTH];
+_Thread_local int traceSpanDepth = 0;
+
+long long getTraceTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+bool isTracing(void)
+{
+  return atomic_load_explicit(&traceRecorder.enabled, memory_order_relaxed);
+}
+
+// Names the calling thread in traces, call it before it records anything
+void setTraceThreadName(const char *name)
+{
+  snprintf(traceThreadName, sizeof(traceThreadName), "%s", name);
+}
+
+// The calling thread's buffer, made the first time it records
+TraceBuffer *getTraceBuffer(void)
+{
+  if (traceBuffer != NULL)
+    return traceBuffer;
+
+  pthread_mutex_lock(&traceRecorder.mutex);
+  int index = atomic_load(&traceRecorder.bufferCount);
+  if (index < TRACE_MAX_THREADS)
+  {
+    traceBuffer = trackedCalloc(MEMORY_THREADING, 1, sizeof(TraceBuffer));
+    traceBuffer->threadId = index + 1;
+    if (traceThreadName[0] != '\0')
+      snprintf(traceBuffer->threadName, sizeof(traceBuffer->threadName), "%s",
+               traceThreadName);
+    else
+      snprintf(traceBuffer->threadName, sizeof(traceBuffer->threadName),
+               "thread %d", index + 1);
+
+    traceRecorder.buffers[index] = traceBuffer;
+    atomic_store(&traceRecorder.bufferCount, index + 1);
+  }
+  pthread_mutex_unlock(&traceRecorder.mutex);
+
+  return traceBuffer;
+}
+
+void addTraceEvent(const char *name, long long start, long long duration,
+                   int kind)
+{
+  if (!isTracing())
+    return;
+
+  TraceBuffer *buffer = getTraceBuffer();
+  if (buffer == NULL)
+    return;
+
+  // stopTrace waits for this flag, so nothing is written while exporting
+  atomic_store(&buffer->recording, true);
+  if (atomic_load(&traceRecorder.enabled))
+  {
+    buffer->events[buffer->eventCount++ % TRACE_BUFFER_EVENTS] =
+        (TraceEvent){name, start, duration, kind};
+  }
+  atomic_store_explicit(&buffer->recording, false, memory_order_release);
+}
+
+void beginTraceSpan(const char *name)
+{
+  if (traceSpanDepth < TRACE_MAX_DEPTH)
+  {
+    traceSpanNames[traceSpanDepth] = name;
+    traceSpanStarts[traceSpanDepth] = isTracing() ? getTraceTime() : 0;
+  }
+  traceSpanDepth++;
+}
+
+void endTraceSpan(void)
+{
+  if (traceSpanDepth == 0)
+    return;
+
+  traceSpanDepth--;
+  if (traceSpanDepth < TRACE_MAX_DEPTH && traceSpanStarts[traceSpanDepth] != 0)
+  {
+    long long start = traceSpanStarts[traceSpanDepth];
+    addTraceEvent(traceSpanNames[traceSpanDepth], start,
+                  getTraceTime() - start, TRACE_SPAN);
+  }
+}
+
+// pthread_mutex_lock that records how long it waited when it had to
+void lockTracedMutex(pthread_mutex_t *mutex, const char *name)
+{
+  if (!isTracing())
+  {
+    pthread_mutex_lock(mutex);
+    return;
+  }
+
+  if (pthread_mutex_trylock(mutex) == 0)
+    return;
+
+  long long start = getTraceTime();
+  pthread_mutex_lock(mutex);
+  addTraceEvent(name, start, getTraceTime() - start, TRACE_WAIT);
+}
+
+void waitTracedCondition(pthread_cond_t *condition, pthread_mutex_t *mutex,
+                         const char *name)
+{
+  long long start = isTracing() ? getTraceTime() : 0;
+  pthread_cond_wait(condition, mutex);
+  if (start != 0)
+    addTraceEvent(name, start, getTraceTime() - start, TRACE_WAIT);
+}
+
+void startTrace(void)
+{
+  if (isTracing())
+    return;
+
+  traceRecorder.startTime = getTraceTime();
+  atomic_store(&traceRecorder.enabled, true);
+}
+
+// Returns once no thread is still adding an event
+void stopTrace(void)
+{
+  atomic_store(&traceRecorder.enabled, false);
+
+  int bufferCount = atomic_load(&traceRecorder.bufferCount);
+  for (int i = 0; i < bufferCount; i++)
+  {
+    while (atomic_load(&traceRecorder.buffers[i]->recording))
+      sched_yield();
+  }
+}
+
+// Writes what was recorded as Chrome trace-event JSON, which Perfetto and
+// chrome://tracing both load, then empties the buffers. Stop tracing first.
+bool writeTrace(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+  {
+    printf("ERROR: Could not write trace %s\n", path);
+    return false;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                "\"args\":{\"name\":\"Thread Wars\"}}");
+
+  long long eventCount = 0;
+  int bufferCount = atomic_load(&traceRecorder.bufferCount);
+  for (int i = 0; i < bufferCount; i++)
+  {
+    TraceBuffer *buffer = traceRecorder.buffers[i];
+    fprintf(file,
+            ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}",
+            buffer->threadId, buffer->threadName);
+
+    unsigned long long first = 0;
+    if (buffer->eventCount > TRACE_BUFFER_EVENTS)
+      first = buffer->eventCount - TRACE_BUFFER_EVENTS;
+
+    for (unsigned long long j = first; j < buffer->eventCount; j++)
+    {
+      TraceEvent *event = &buffer->events[j % TRACE_BUFFER_EVENTS];
+      if (event->start < traceRecorder.startTime)
+        continue;
+
+      fprintf(file,
+              ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+              "\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+              event->name, event->kind == TRACE_WAIT ? "wait" : "span",
+              (event->start - traceRecorder.startTime) / 1000.0,
+              event->duration / 1000.0, buffer->threadId);
+      eventCount++;
+    }
+
+    buffer->eventCount = 0;
+  }
+
+  fprintf(file, "\n]}\n");
+  bool written = fclose(file) == 0;
+
+  if (written)
+    printf("Wrote %lld trace events to %s\n", eventCount, path);
+  else
+    printf("ERROR: Could not write trace %s\n", path);
+
+  return written;
+}
+
+// Starts tracing, or stops it and writes the trace to path
+void toggleTrace(const char *path)
+{
+  if (isTracing())
+  {
+    stopTrace();
+    writeTrace(path);
+  }
+  else
+  {
+    startTrace();
+  }
+}
+
+// Only once every other thread that traced has been joined
+void destroyTraceRecorder(void)
+{
+  stopTrace();
+
+  int bufferCount = atomic_load(&traceRecorder.bufferCount);
+  for (int i = 0; i < bufferCount; i++)
+  {
+    trackedFree(traceRecorder.buffers[i]);
+    traceRecorder.buffers[i] = NULL;
+  }
+  atomic_store(&traceRecorder.bufferCount, 0);
+  traceBuffer = NULL;
+}
@@ -0,0 +1,31 @@
+#include "trace_recorder.c"
+
+long long getTraceTime(void);
+
+bool isTracing(void);
+
+void setTraceThreadName(const char *name);
+
+TraceBuffer *getTraceBuffer(void);
+
+void addTraceEvent(const char *name, long long start, long long duration,
+                   int kind);
+
+void beginTraceSpan(const char *name);
+
+void endTraceSpan(void);
+
+void lockTracedMutex(pthread_mutex_t *mutex, const char *name);
+
+void waitTracedCondition(pthread_cond_t *condition, pthread_mutex_t *mutex,
+                         const char *name);
+
+void startTrace(void);
+
+void stopTrace(void);
+
+bool writeTrace(const char *path);
+
+void toggleTrace(const char *path);
+
+void destroyTraceRecorder(void);
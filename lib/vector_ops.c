@@ -29,4 +29,26 @@ Vector2 getDirectionVector2s(Vector2 v1, Vector2 v2)
 
   return (Vector2){(v2.x - v1.x) / getDistanceBetweenVectors(v1, v2),
                    (v2.y - v1.y) / getDistanceBetweenVectors(v1, v2)};
-}
\ No newline at end of file
+}
+
+// How far along the segment from -> to it first touches the circle, from 0
+// to 1, or -1 if it misses. A segment starting inside the circle hits at 0.
+float getSegmentCircleHit(Vector2 from, Vector2 to, Vector2 center,
+                          float radius)
+{
+  Vector2 d = {to.x - from.x, to.y - from.y};
+  Vector2 f = {from.x - center.x, from.y - center.y};
+
+  float c = f.x * f.x + f.y * f.y - radius * radius;
+  if (c <= 0)
+    return 0;
+
+  float a = d.x * d.x + d.y * d.y;
+  float b = 2 * (f.x * d.x + f.y * d.y);
+  float discriminant = b * b - 4 * a * c;
+  if (a == 0 || discriminant < 0)
+    return -1;
+
+  float t = (-b - sqrtf(discriminant)) / (2 * a);
+  return t >= 0 && t <= 1 ? t : -1;
+}
@@ -6,4 +6,7 @@ float getVectorMagnitude(Vector2 v);
 
 Vector2 normalizeVector2(Vector2 v);
 
-Vector2 getDirectionVector2s(Vector2 v1, Vector2 v2);
\ No newline at end of file
+Vector2 getDirectionVector2s(Vector2 v1, Vector2 v2);
+
+float getSegmentCircleHit(Vector2 from, Vector2 to, Vector2 center,
+                          float radius);
@@ -0,0 +1,146 @@
+#include <math.h>
+#include <stdlib.h>
+
+// Mixes the world seed with a chunk's index, so each chunk generates the
+// same content however and whenever it is first reached
+unsigned int getChunkSeed(unsigned int seed, int index)
+{
+  unsigned int hash = seed ^ ((unsigned int)index * 2654435761u);
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3bu;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+void resetWorld(World *world)
+{
+  for (int i = 0; i < world->columns * world->rows; i++)
+  {
+    WorldChunk *chunk = &world->chunks[i];
+    trackedFree(chunk->data);
+    chunk->data = NULL;
+    chunk->cellCount = 0;
+    chunk->enemyCount = 0;
+    chunk->state = WORLD_CHUNK_UNLOADED;
+    chunk->randomState = getChunkSeed(world->seed, i);
+  }
+
+  world->activeCount = 0;
+  world->storedBytes = 0;
+}
+
+void initializeWorld(World *world, Vector2 origin, float extent,
+                     float chunkSize, unsigned int seed)
+{
+  world->origin = origin;
+  world->chunkSize = chunkSize;
+  world->columns = (int)ceilf(extent / chunkSize);
+  if (world->columns < 1)
+    world->columns = 1;
+  world->rows = world->columns;
+  world->seed = seed;
+
+  int chunkCount = world->columns * world->rows;
+  world->chunks =
+      trackedCalloc(MEMORY_ENTITIES, chunkCount, sizeof(WorldChunk));
+  world->activeChunks =
+      trackedMalloc(MEMORY_ENTITIES, chunkCount * sizeof(int));
+
+  resetWorld(world);
+}
+
+// Positions outside the world belong to the nearest edge chunk
+int getChunkColumn(World *world, float x)
+{
+  int column = (int)floorf((x - world->origin.x) / world->chunkSize);
+  if (column < 0)
+    return 0;
+  if (column >= world->columns)
+    return world->columns - 1;
+  return column;
+}
+
+int getChunkRow(World *world, float y)
+{
+  int row = (int)floorf((y - world->origin.y) / world->chunkSize);
+  if (row < 0)
+    return 0;
+  if (row >= world->rows)
+    return world->rows - 1;
+  return row;
+}
+
+int getChunkIndex(World *world, Vector2 position)
+{
+  return getChunkRow(world, position.y) * world->columns +
+         getChunkColumn(world, position.x);
+}
+
+Vector2 getChunkOrigin(World *world, int index)
+{
+  int column = index % world->columns;
+  int row = index / world->columns;
+
+  return (Vector2){world->origin.x + column * world->chunkSize,
+                   world->origin.y + row * world->chunkSize};
+}
+
+// Packs an evicted chunk's cells then enemies as 16-bit offsets from the
+// chunk's corner, 4 bytes an entity
+void storeChunkData(World *world, int index, Vector2 *positions,
+                    int cellCount, int enemyCount)
+{
+  WorldChunk *chunk = &world->chunks[index];
+  Vector2 origin = getChunkOrigin(world, index);
+  int count = cellCount + enemyCount;
+
+  chunk->cellCount = cellCount;
+  chunk->enemyCount = enemyCount;
+  chunk->data = NULL;
+  if (count == 0)
+    return;
+
+  chunk->data = trackedMalloc(MEMORY_ENTITIES, count * 2 * sizeof(uint16_t));
+  for (int i = 0; i < count; i++)
+  {
+    float x = fminf(fmaxf(positions[i].x - origin.x, 0), UINT16_MAX);
+    float y = fminf(fmaxf(positions[i].y - origin.y, 0), UINT16_MAX);
+    chunk->data[i * 2] = (uint16_t)x;
+    chunk->data[i * 2 + 1] = (uint16_t)y;
+  }
+
+  world->storedBytes += count * 2 * sizeof(uint16_t);
+}
+
+// i counts cells first, then enemies
+Vector2 getStoredPosition(World *world, int index, int i)
+{
+  WorldChunk *chunk = &world->chunks[index];
+  Vector2 origin = getChunkOrigin(world, index);
+
+  return (Vector2){origin.x + chunk->data[i * 2],
+                   origin.y + chunk->data[i * 2 + 1]};
+}
+
+void freeChunkData(World *world, int index)
+{
+  WorldChunk *chunk = &world->chunks[index];
+
+  world->storedBytes -=
+      (chunk->cellCount + chunk->enemyCount) * 2 * sizeof(uint16_t);
+  trackedFree(chunk->data);
+  chunk->data = NULL;
+  chunk->cellCount = 0;
+  chunk->enemyCount = 0;
+}
+
+void destroyWorld(World *world)
+{
+  for (int i = 0; i < world->columns * world->rows; i++)
+  {
+    trackedFree(world->chunks[i].data);
+  }
+
+  trackedFree(world->chunks);
+  trackedFree(world->activeChunks);
+}
@@ -0,0 +1,25 @@
+#include "world.c"
+
+unsigned int getChunkSeed(unsigned int seed, int index);
+
+void resetWorld(World *world);
+
+void initializeWorld(World *world, Vector2 origin, float extent,
+                     float chunkSize, unsigned int seed);
+
+int getChunkColumn(World *world, float x);
+
+int getChunkRow(World *world, float y);
+
+int getChunkIndex(World *world, Vector2 position);
+
+Vector2 getChunkOrigin(World *world, int index);
+
+void storeChunkData(World *world, int index, Vector2 *positions,
+                    int cellCount, int enemyCount);
+
+Vector2 getStoredPosition(World *world, int index, int i);
+
+void freeChunkData(World *world, int index);
+
+void destroyWorld(World *world);
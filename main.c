@@ -1,221 +1,262 @@
 #include "lib/models.h"
+#include "lib/memory_tracker.h"
+#include "lib/trace_recorder.h"
+#include "lib/asset_bundle.h"
+#include "lib/asset_manager.h"
+#include "lib/music_player.h"
 #include "lib/vector_ops.h"
+#include "lib/entity_store.h"
+#include "lib/spatial_grid.h"
+#include "lib/obstacle_tree.h"
+#include "lib/minimap.h"
+#include "lib/world.h"
+#include "lib/game_events.h"
+#include "lib/game.h"
+#include "lib/job_system.h"
+#include "lib/save_game.h"
+#include "lib/render_prep.h"
+#include "lib/resolution_scaler.h"
+#include "lib/latency_tracker.h"
+#include "lib/net.h"
 #include "raylib.h"
 #include <limits.h>
+#include <math.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 /*
     Stores keymaps for each player
-    Sequence: Up, Left, Down, Right
+    Sequence: Up, Left, Down, Right, Shoot, Build Small, Build Large
 */
-int controls[3][7] = {
+int controls[MAX_PLAYERS][7] = {
     {KEY_W, KEY_A, KEY_S, KEY_D, KEY_SPACE, KEY_ONE, KEY_TWO},
     {KEY_UP, KEY_LEFT, KEY_DOWN, KEY_RIGHT, KEY_ENTER, KEY_NINE, KEY_ZERO},
+    {KEY_T, KEY_F, KEY_G, KEY_H, KEY_R, KEY_THREE, KEY_FOUR},
+    {KEY_I, KEY_J, KEY_K, KEY_L, KEY_U, KEY_SEVEN, KEY_EIGHT},
+    {KEY_KP_8, KEY_KP_4, KEY_KP_5, KEY_KP_6, KEY_KP_0, KEY_KP_7, KEY_KP_9},
+    {KEY_HOME, KEY_DELETE, KEY_END, KEY_PAGE_DOWN, KEY_INSERT, KEY_F1,
+     KEY_F2},
+    {KEY_LEFT_BRACKET, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_BACKSLASH,
+     KEY_RIGHT_SHIFT, KEY_COMMA, KEY_PERIOD},
+    {KEY_Z, KEY_X, KEY_C, KEY_V, KEY_B, KEY_N, KEY_M},
 };
 
-MultiSound *initMultiSound(char filename[])
-{
-  MultiSound *multiSound = malloc(sizeof(MultiSound));
+// Shown in the controls menu, one line per action group
+const char *controlDescriptions[MAX_PLAYERS][3] = {
+    {"WASD - Move", "SPACE - Shoot", "1/2 - Build Solar"},
+    {"ARROWS - Move", "ENTER - Shoot", "9/0 - Build Solar"},
+    {"TFGH - Move", "R - Shoot", "3/4 - Build Solar"},
+    {"IJKL - Move", "U - Shoot", "7/8 - Build Solar"},
+    {"NUMPAD 8456 - Move", "NUMPAD 0 - Shoot", "NUMPAD 7/9 - Build Solar"},
+    {"HOME/DEL/END/PGDN - Move", "INSERT - Shoot", "F1/F2 - Build Solar"},
+    {"[ ; ' \\ - Move", "RIGHT SHIFT - Shoot", ", / . - Build Solar"},
+    {"Z X C V - Move", "B - Shoot", "N/M - Build Solar"},
+};
 
-  multiSound->buffsize = 50;
-  multiSound->currentBuff = 0;
-  multiSound->buffer = calloc(sizeof(Sound), multiSound->buffsize);
+// Queues every file the game loads so it can be decoded in the background
+void queueGameAssets(AssetManager *assets)
+{
+  queueAsset(assets, "assets/player1.png", true);
+  queueAsset(assets, "assets/player2.png", true);
+  queueAsset(assets, "assets/zombie.png", true);
 
-  // load audio into first
-  multiSound->buffer[0] = LoadSound(filename);
+  queueAsset(assets, "assets/audio/shoot.wav", false);
+  queueAsset(assets, "assets/audio/pickup.wav", false);
+  queueAsset(assets, "assets/audio/place.wav", false);
+  queueAsset(assets, "assets/audio/noAmmo.wav", false);
 
-  // create aliases everywhere else
-  for (int i = 0; i < multiSound->buffsize; i++)
+  for (int i = 0; i < 7; i++)
   {
-    multiSound->buffer[i] = LoadSoundAlias(multiSound->buffer[0]);
+    char filename[128];
+    sprintf(filename, "assets/audio/zombie/zombie%d.wav", i + 1);
+    queueAsset(assets, filename, false);
   }
-
-  return multiSound;
 }
 
-void playMultiSound(MultiSound *multiSound)
+// Uploads decoded assets a few milliseconds per frame while showing progress
+bool showLoadingScreen(Game *game)
 {
-  PlaySound(multiSound->buffer[multiSound->currentBuff]);
-  multiSound->currentBuff =
-      (multiSound->currentBuff + 1) % multiSound->buffsize;
-}
-
-void initGameSounds(Game *game)
-{
-  game->sound = calloc(sizeof(GameSound), 1);
+  while (!areAssetsLoaded(game->assets))
+  {
+    if (WindowShouldClose())
+      return false;
 
-  game->sound->music = LoadSound("assets/audio/music.wav");
+    uploadDecodedAssets(game->assets, 0.008);
 
-  game->sound->shoot = initMultiSound("assets/audio/shoot.wav");
-  game->sound->pickup = initMultiSound("assets/audio/pickup.wav");
-  game->sound->place = initMultiSound("assets/audio/place.wav");
-  game->sound->noAmmo = initMultiSound("assets/audio/noAmmo.wav");
+    float progress = getAssetLoadingProgress(game->assets);
+    int barWidth = GetScreenWidth() * 0.4;
+    int barHeight = 20;
+    int barX = GetScreenWidth() / 2 - barWidth / 2;
+    int barY = GetScreenHeight() / 2;
 
-  printf("HERE\n");
-  for (int i = 0; i < 7; i++)
-  {
-    char filename[128];
-    sprintf(filename, "assets/audio/zombie/zombie%d.wav", i + 1);
-    printf("%s\n", filename);
-    game->sound->zombie[i] = LoadSound(filename);
+    BeginDrawing();
+    ClearBackground(BLACK);
+    DrawText("Loading...",
+             GetScreenWidth() / 2 - MeasureText("Loading...", 45) / 2,
+             barY - 70, 45, WHITE);
+    DrawRectangle(barX, barY, barWidth, barHeight, GRAY);
+    DrawRectangle(barX, barY, barWidth * progress, barHeight, GREEN);
+    EndDrawing();
   }
-};
-
-void drawMessage(Game *game)
-{
-  int messageFontSize = 45;
 
-  DrawRectangle(GetScreenWidth() * 0.5 -
-                    (double)MeasureText(game->message, messageFontSize) * 0.5,
-                GetScreenHeight() * 0.5 - messageFontSize * 0.5,
-                MeasureText(game->message, messageFontSize), messageFontSize,
-                (Color){0, 0, 0, 255 * game->messageOpacity});
-
-  DrawText(game->message,
-           GetScreenWidth() * 0.5 -
-               (double)MeasureText(game->message, messageFontSize) * 0.5,
-           GetScreenHeight() * 0.5 - messageFontSize * 0.5, messageFontSize,
-           (Color){255, 255, 255, 255 * game->messageOpacity});
+  return true;
 }
 
-void updateMessage(Game *game)
+// Takes a sound from the asset manager, falling back to the file on disk
+Sound loadGameSound(Game *game, const char *filename)
 {
-  game->messageOpacity =
-      1 - ((float)(game->frameCount - game->messageAddedFrame) /
-           (game->messageDuration * game->targetFPS));
-
-  if (game->messageOpacity > 1)
-    game->messageOpacity = 1;
-  if (game->messageOpacity < 0)
-    game->messageOpacity = 0;
+  Sound sound;
+  if (getLoadedSound(game->assets, filename, &sound))
+  {
+    return sound;
+  }
+
+  return LoadSound(filename);
 }
 
-void showMessage(Game *game, char message[], int fontSize)
+// Takes a texture from the asset manager, falling back to the file on disk
+Texture2D loadGameTexture(Game *game, const char *filename)
 {
-  sprintf(game->message, "%s", message);
-  game->messageFontSize = fontSize;
-  game->messageAddedFrame = game->frameCount;
-  game->messageOpacity = 1;
+  Texture2D texture;
+  if (getLoadedTexture(game->assets, filename, &texture))
+  {
+    return texture;
+  }
+
+  return LoadTexture(filename);
 }
 
-void *computeSolarChargers(void *arg)
+// How many copies of a sound can play over each other
+#define MULTI_SOUND_VOICES 16
+
+MultiSound *initMultiSound(Game *game, char filename[])
 {
+  MultiSound *multiSound = trackedMalloc(MEMORY_AUDIO, sizeof(MultiSound));
 
-  Game *game = ((SolarChargingComputerThreadArgument *)(arg))->game;
-  int j =
-      ((SolarChargingComputerThreadArgument *)(arg))->solarChargerComputerIndex;
-  free(arg);
+  multiSound->buffsize = MULTI_SOUND_VOICES;
+  multiSound->currentBuff = 0;
+  multiSound->buffer =
+      trackedCalloc(MEMORY_AUDIO, multiSound->buffsize, sizeof(Sound));
 
-  int localFrameCount = -1;
+  // load audio into first
+  multiSound->buffer[0] = loadGameSound(game, filename);
 
-  while (true)
+  // create aliases everywhere else
+  for (int i = 1; i < multiSound->buffsize; i++)
   {
-    if (localFrameCount == game->frameCount)
-    {
-      continue;
-    }
+    multiSound->buffer[i] = LoadSoundAlias(multiSound->buffer[0]);
+  }
 
-    localFrameCount = game->frameCount;
+  return multiSound;
+}
 
-    for (int i = j * (game->maxSolarChargers / game->numSolarChargesComputers);
-         i <
-         (j + 1) * (game->maxSolarChargers / game->numSolarChargesComputers);
-         i++)
-    {
-      if (game->solarChargers[i].active)
-      {
+void initGameSounds(Game *game)
+{
+  game->sound = trackedCalloc(MEMORY_AUDIO, 1, sizeof(GameSound));
 
-        // Get charge value
-        float chargeValue = ((float)(game->solarChargers[i].height *
-                                     game->solarChargers[i].width) /
-                             100000) /
-                            game->targetFPS;
+  // Music is streamed rather than decoded up front
+  const char *musicFiles[] = {"assets/audio/music.qoa",
+                              "assets/audio/music.ogg",
+                              "assets/audio/music.wav"};
+  game->sound->music = startMusicPlayer(musicFiles, 3);
 
-        // Charge the battery
-        pthread_mutex_lock(&game->batteryMutex);
-        game->battery += chargeValue;
-        pthread_mutex_unlock(&game->batteryMutex);
-      }
-    }
+  game->sound->shoot = initMultiSound(game, "assets/audio/shoot.wav");
+  game->sound->pickup = initMultiSound(game, "assets/audio/pickup.wav");
+  game->sound->place = initMultiSound(game, "assets/audio/place.wav");
+  game->sound->noAmmo = initMultiSound(game, "assets/audio/noAmmo.wav");
 
-    if (game->isQuitting)
-    {
-      pthread_exit(NULL);
-    }
+  for (int i = 0; i < 7; i++)
+  {
+    char filename[128];
+    sprintf(filename, "assets/audio/zombie/zombie%d.wav", i + 1);
+    game->sound->zombie[i] = loadGameSound(game, filename);
   }
-}
+};
 
-void initializeSolarChargers(Game *game)
+void unloadMultiSound(MultiSound *multiSound)
 {
-  game->solarChargers = calloc(game->maxSolarChargers, sizeof(SolarCharger));
-
-  for (int i = 0; i < game->maxSolarChargers; i++)
+  for (int i = 1; i < multiSound->buffsize; i++)
   {
-    game->solarChargers[i].active = false;
-    game->solarChargers[i].height = 0;
-    game->solarChargers[i].width = 0;
-    game->solarChargers[i].position = (Vector2){0, 0};
+    UnloadSoundAlias(multiSound->buffer[i]);
   }
+  UnloadSound(multiSound->buffer[0]);
 
-  game->solarChargesComputingThreads =
-      (pthread_t *)calloc(game->numSolarChargesComputers, sizeof(pthread_t));
+  trackedFree(multiSound->buffer);
+  trackedFree(multiSound);
+}
 
-  // Start computing threads for solar charges
-  for (int i = 0; i < game->numSolarChargesComputers; i++)
-  {
+void unloadGameSounds(Game *game)
+{
+  stopMusicPlayer(game->sound->music);
 
-    SolarChargingComputerThreadArgument *arg =
-        malloc(sizeof(SolarChargingComputerThreadArgument));
-    arg->solarChargerComputerIndex = i;
-    arg->game = game;
+  unloadMultiSound(game->sound->shoot);
+  unloadMultiSound(game->sound->pickup);
+  unloadMultiSound(game->sound->place);
+  unloadMultiSound(game->sound->noAmmo);
 
-    pthread_create(&game->solarChargesComputingThreads[i], NULL,
-                   computeSolarChargers, (void *)arg);
+  // Zombie groans are aliases, they go before the sounds they share
+  for (int i = 0; i < game->enemies.capacity; i++)
+  {
+    if (game->enemies.sounds[i].frameCount > 0)
+      UnloadSoundAlias(game->enemies.sounds[i]);
   }
-}
 
-void buildSolarCharger(Game *game, Vector2 position, int size)
-{
-
-  if (game->solarCellsCollected < size * 10)
+  for (int i = 0; i < 7; i++)
   {
-    showMessage(game, "Not enough solar cells, collect more.", 20);
-    return;
+    UnloadSound(game->sound->zombie[i]);
   }
 
-  pthread_mutex_lock(&game->solarCellsMutex);
-  playMultiSound(game->sound->place);
-  game->solarCellsCollected -= size * 10;
-  pthread_mutex_unlock(&game->solarCellsMutex);
+  trackedFree(game->sound);
+  game->sound = NULL;
+}
+
+// Plays the sounds and shows the messages for everything the simulation
+// reported since the last frame. Only the main thread calls this.
+void handleGameEvents(Game *game)
+{
+  GameEvent event;
+  char message[256];
 
-  for (int i = 0; i < game->maxSolarChargers; i++)
+  while (popGameEvent(game->events, &event))
   {
-    if (!game->solarChargers[i].active)
+    switch (event.type)
     {
-      game->solarChargers[i].active = true;
-      game->solarChargers[i].height = 100;
-      game->solarChargers[i].width = size * 100;
-      game->solarChargers[i].position = position;
-
+    case GAME_EVENT_SHOT_FIRED:
+      playMultiSound(game->sound->shoot);
+      break;
+    case GAME_EVENT_ENEMY_KILLED:
+      if (!game->headless)
+        StopSound(game->enemies.sounds[event.index]);
+      break;
+    case GAME_EVENT_CELL_PICKED:
+      playMultiSound(game->sound->pickup);
+      break;
+    case GAME_EVENT_CHARGER_BUILT:
+      playMultiSound(game->sound->place);
+      break;
+    case GAME_EVENT_NOT_ENOUGH_CELLS:
+      showMessage(game, "Not enough solar cells, collect more.", 20);
+      break;
+    case GAME_EVENT_OUT_OF_AMMO:
+      playMultiSound(game->sound->noAmmo);
+      showMessage(game, "[!] Not enough battery, make solar panels", 20);
+      break;
+    case GAME_EVENT_WAVE_STARTED:
+      sprintf(message, "WAVE %d begins!", event.index);
+      showMessage(game, message, 45);
       break;
     }
   }
 }
 
-// In initializePlayers function:
-void initializePlayers(Game *game)
+// Only needed by games with a window
+void loadGameTextures(Game *game)
 {
-  Color playerColors[] = {YELLOW, BLUE, GREEN, PINK};
-
-  game->players = (Player *)calloc(sizeof(Player), game->playerCount);
-
   // Load player textures - make sure the path is correct
-  game->playerTextures[0] = LoadTexture("assets/player1.png");
-  game->playerTextures[1] = LoadTexture("assets/player2.png");
+  game->playerTextures[0] = loadGameTexture(game, "assets/player1.png");
+  game->playerTextures[1] = loadGameTexture(game, "assets/player2.png");
 
   // Verify textures loaded correctly
   if (game->playerTextures[0].id == 0 || game->playerTextures[1].id == 0)
@@ -224,102 +265,53 @@ void initializePlayers(Game *game)
     exit(1);
   }
 
-  for (int i = 0; i < game->playerCount; i++)
-  {
-    game->players[i].size = 100;
-    game->players[i].flipDir = 1;
-    game->players[i].speed = (float)600 / game->targetFPS;
-    game->players[i].health = 100;
-    game->players[i].color = playerColors[i % game->playerCount];
-    game->players[i].position =
-        (Vector2){0 + i * (20 + game->players[i].size), 0};
-
-    for (int j = 0; j < game->playerCount; j++)
-    {
-      if (pthread_mutex_init(&game->players[j].mutex, NULL))
-      {
-        exit(0);
-      };
-    }
-  }
-}
-
-int getClosestEnemyIndex(Game *game, Vector2 from)
-{
-  float shortestDistance = INT_MAX;
-  int closestEnemyIndex = -1;
-
-  for (int i = 0; i < game->maxEnemies; i++)
-  {
-    if (game->enemies[i].active)
-    {
-
-      float distance =
-          getDistanceBetweenVectors(game->enemies[i].position, from);
-
-      if (distance < shortestDistance)
-      {
-        shortestDistance = distance;
-        closestEnemyIndex = i;
-      }
-    }
-  };
-
-  return closestEnemyIndex;
+  game->zombieTexture = loadGameTexture(game, "assets/zombie.png");
 }
 
-void drawAimLine(Game *game, Player *player)
+void drawAimLine(Game *game, int playerIndex, Vector2 playerPosition)
 {
-  int closestEnemyIndex = getClosestEnemyIndex(game, player->position);
-  Vector2 enemyPos = game->enemies[closestEnemyIndex].position;
-
-  if (closestEnemyIndex != -1 &&
-      getDistanceBetweenVectors(player->position, enemyPos) <= game->gunRange)
+  // Target was found during the shared render prep pass
+  if (game->renderPrep->aimTargets[playerIndex] != -1)
   {
+    Vector2 enemyPos = game->renderPrep->aimTargetPositions[playerIndex];
 
-    DrawLine(player->position.x, player->position.y, enemyPos.x, enemyPos.y,
+    DrawLine(playerPosition.x, playerPosition.y, enemyPos.x, enemyPos.y,
              YELLOW);
   }
 }
 
-void initializeEnemies(Game *game)
+bool isDensityViewport(Viewport *viewport)
 {
-  game->enemies = calloc(game->maxEnemies, sizeof(Enemy));
-
-  game->zombieTexture = LoadTexture("assets/zombie.png");
-
-  int range = (int)(GetScreenWidth() / game->playerCount);
-
-  for (int i = 0; i < game->maxEnemies; i++)
-  {
-    game->enemies[i].size = 30;
-    game->enemies[i].color = RED;
-    game->enemies[i].active = false;
-    game->enemies[i].damage = 5;
-    game->enemies[i].speed = (100 + (rand() % 101)) / game->targetFPS;
-    game->enemies[i].position = (Vector2){((rand() % range) - (float)range / 2),
-                                          (rand() % range) - (float)range / 2};
-    game->enemies->sound = LoadSoundAlias(game->sound->zombie[rand() % 7]);
-  }
+  return viewport->camera->zoom < RENDER_DENSITY_ZOOM;
 }
 
-void initializeWaves(Game *game)
+// Tells the simulation how far the widest view reaches, so every enemy in
+// it gets the full update. Zoomed out, only the enemies drawn as sprites
+// near a player count, and the heat map is sized to the view instead.
+void updateViewHalfExtent(Game *game)
 {
-  game->waves = calloc(sizeof(EnemyWave), game->numWaves);
+  Vector2 extent = {0, 0}, densityExtent = {0, 0};
 
-  // Setting up waves
-  game->waves[0].numEnemies = 5;
-  game->waves[0].waitTime = 10;
+  for (int i = 0; i < game->viewportCount; i++)
+  {
+    Viewport *viewport = &game->viewports[i];
+    Vector2 half = {viewport->screenRect.width / 2 / viewport->camera->zoom,
+                    viewport->screenRect.height / 2 / viewport->camera->zoom};
 
-  game->waves[1].numEnemies = 25;
-  game->waves[1].waitTime = 40;
+    if (isDensityViewport(viewport))
+    {
+      densityExtent.x = fmaxf(densityExtent.x, half.x);
+      densityExtent.y = fmaxf(densityExtent.y, half.y);
+      half = (Vector2){RENDER_DENSITY_SPRITE_RANGE,
+                       RENDER_DENSITY_SPRITE_RANGE};
+    }
 
-  game->waves[2].numEnemies = 50;
-  game->waves[2].waitTime = 80;
+    extent.x = fmaxf(extent.x, half.x);
+    extent.y = fmaxf(extent.y, half.y);
+  }
 
-  game->lastWaveFrame = 0;
-  game->currentWave = 0;
-  game->frameCount = 0;
+  game->viewHalfExtent = extent;
+  game->densityHalfExtent = densityExtent;
 }
 
 // Function to create and initialize viewports
@@ -328,32 +320,36 @@ void initializeViewports(Game *game)
 
   // Allocating in memory
   RenderTexture2D *renderTextures =
-      calloc(sizeof(RenderTexture2D), game->playerCount);
-  Camera2D *cameras = calloc(sizeof(Camera2D), game->playerCount);
-  game->viewports = calloc(game->playerCount, sizeof(Viewport));
-
-  // Initializing semaphores, setting the first one as active
-  sem_init(&game->viewports[0].inputSemaphore, 0, 1);
-
-  // Initializing the rest as inactive
-  for (int i = 1; i < game->playerCount; i++)
+      trackedCalloc(MEMORY_RENDER, game->viewportCount,
+                    sizeof(RenderTexture2D));
+  Camera2D *cameras =
+      trackedCalloc(MEMORY_RENDER, game->viewportCount, sizeof(Camera2D));
+  game->viewports =
+      trackedCalloc(MEMORY_RENDER, game->viewportCount, sizeof(Viewport));
+
+  // Laying viewports out in a grid, the last row stretches to fill the width
+  int columns = (int)ceilf(sqrtf(game->viewportCount));
+  int rows = (game->viewportCount + columns - 1) / columns;
+  int viewportHeight = GetScreenHeight() / rows;
+
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    sem_init(&game->viewports[i].inputSemaphore, 0, 0);
-  }
+    int row = i / columns;
+    int rowColumns = row == rows - 1 ? game->viewportCount - row * columns
+                                     : columns;
+    int viewportWidth = GetScreenWidth() / rowColumns;
 
-  for (int i = 0; i < game->playerCount; i++)
-  {
-    // Creating render textures
-    renderTextures[i] = LoadRenderTexture(GetScreenWidth() / game->playerCount,
-                                          GetScreenHeight());
+    game->viewports[i].screenRect =
+        (Rectangle){(i % columns) * viewportWidth, row * viewportHeight,
+                    viewportWidth, viewportHeight};
 
-    // Setting up cameras
+    // Setting up cameras, the offset follows the render texture size
     cameras[i].zoom = 1.0;
-    cameras[i].offset = (Vector2){(int)(renderTextures[i].texture.width / 2),
-                                  (int)(renderTextures[i].texture.height / 2)};
 
-    // Setting a render texture to viewport
+    // Setting a render texture to viewport, starting at full resolution
     game->viewports[i].renderTexture = &renderTextures[i];
+    setViewportResolutionScale(&game->viewports[i],
+                               game->resolution.maxScale);
 
     // Setting a camera to viewport
     game->viewports[i].camera = &cameras[i];
@@ -361,483 +357,501 @@ void initializeViewports(Game *game)
     // Setting a player to viewport
     game->viewports[i].player = &game->players[i];
   }
+
+  game->renderPrep = createRenderPrep(game, 256);
+  game->nextRenderPrep = createRenderPrep(game, 256);
+
+  // One heat map pixel per density cell, smoothed when stretched over the
+  // views. Each frame only fills the corner its window needs.
+  Image density = GenImageColor(RENDER_DENSITY_TEXTURE_SIZE,
+                                RENDER_DENSITY_TEXTURE_SIZE, BLANK);
+  game->densityTexture = LoadTextureFromImage(density);
+  UnloadImage(density);
+  SetTextureFilter(game->densityTexture, TEXTURE_FILTER_BILINEAR);
+
+  Image minimap = GenImageColor(MINIMAP_SIZE, MINIMAP_SIZE, BLANK);
+  game->minimapTexture = LoadTextureFromImage(minimap);
+  UnloadImage(minimap);
+  atomic_store(&game->minimap.changed, true); // fill the new texture
+
+  updateViewHalfExtent(game);
 }
 
-void initializeSolarCells(Game *game)
+// Reads a control scheme from the keyboard
+PlayerInput samplePlayerInput(int controlScheme)
 {
-  game->solarCells = calloc(game->maxSolarCells, sizeof(SolarCell));
-
-  for (int i = 0; i < game->maxSolarCells; i++)
-  {
-    game->solarCells[i].active = false;
-    game->solarCells[i].position = (Vector2){0, 0};
-    game->solarCells[i].size = 0;
-  }
+  PlayerInput input = {0, 0};
+
+  // Movement controls (using simplified array access)
+  if (IsKeyDown(controls[controlScheme][0]))
+    input.held |= INPUT_UP;
+  if (IsKeyDown(controls[controlScheme][1]))
+    input.held |= INPUT_LEFT;
+  if (IsKeyDown(controls[controlScheme][2]))
+    input.held |= INPUT_DOWN;
+  if (IsKeyDown(controls[controlScheme][3]))
+    input.held |= INPUT_RIGHT;
+
+  if (IsKeyPressed(controls[controlScheme][4]))
+    input.pressed |= INPUT_SHOOT;
+  if (IsKeyPressed(controls[controlScheme][5]))
+    input.pressed |= INPUT_BUILD_SMALL;
+  if (IsKeyPressed(controls[controlScheme][6]))
+    input.pressed |= INPUT_BUILD_LARGE;
+
+  return input;
 }
 
-void addSolarCell(Game *game, Vector2 position)
+// Zoom goes up and down in steps of the same ratio, far enough out to see
+// the whole largest map
+#define CAMERA_ZOOM_STEP 1.25f
+#define MIN_CAMERA_ZOOM 0.05f
+#define MAX_CAMERA_ZOOM 4.0f
+
+void handleZoomKeys(Game *game)
 {
+  float step = 1;
+  if (IsKeyPressed(KEY_EQUAL))
+    step = CAMERA_ZOOM_STEP;
+  if (IsKeyPressed(KEY_MINUS))
+    step = 1 / CAMERA_ZOOM_STEP;
 
-  pthread_mutex_lock(&game->solarCellsMutex);
-  for (int i = 0; i < game->maxSolarCells; i++)
-  {
+  if (step == 1)
+    return;
 
-    if (!game->solarCells[i].active)
-    {
-      game->solarCells[i].active = true;
-      game->solarCells[i].position = position;
-      game->solarCells[i].size = 20;
-      break;
-    }
+  for (int i = 0; i < game->viewportCount; i++)
+  {
+    Camera2D *camera = game->viewports[i].camera;
+    camera->zoom =
+        fminf(fmaxf(camera->zoom * step, MIN_CAMERA_ZOOM), MAX_CAMERA_ZOOM);
   }
-  pthread_mutex_unlock(&game->solarCellsMutex);
+  updateViewHalfExtent(game);
+  game->pausedFrameValid = false;
 }
 
-void generateSolarCells(Game *game)
+#define ENEMIES_PER_JOB 32
+#define CHARGERS_PER_JOB 64
+#define PROJECTILES_PER_JOB 256
+
+// Input is read on the main thread, EndDrawing polls it while the next
+// tick is simulated
+void sampleInputs(Game *game)
 {
-  // Generate n solar cells in random places
-  int n = 20;
-  int radius = game->mapSize / 2;
-  for (int i = 0; i < n; i++)
+  for (int i = 0; i < game->playerCount; i++)
   {
-    addSolarCell(game, (Vector2){(rand() % radius * 2) - radius,
-                                 (rand() % radius * 2) - radius});
+    game->playerInputs[i] = samplePlayerInput(i % MAX_PLAYERS);
   }
+  game->inputTime = game->latency.pollTime;
 }
 
-void drawSolarCells(Game *game)
+void movePlayerJob(void *data, int index)
 {
-  for (int i = 0; i < game->maxSolarCells; i++)
-  {
-    if (game->solarCells[i].active)
-    {
-      DrawRectangleRounded((Rectangle){game->solarCells[i].position.x -
-                                           (float)game->solarCells[i].size / 2,
-                                       game->solarCells[i].position.y -
-                                           (float)game->solarCells[i].size / 2,
-                                       game->solarCells[i].size,
-                                       game->solarCells[i].size},
-                           1, 1, GRAY);
-    }
-  }
+  Game *game = (Game *)data;
+  movePlayer(game, &game->players[index], game->playerInputs[index]);
 }
 
-void removeSolarCell(Game *game, int cellIndex)
+void updateEnemiesJob(void *data, int index)
 {
+  Game *game = (Game *)data;
+  int start = index * ENEMIES_PER_JOB;
 
-  game->solarCells[cellIndex].active = false;
+  updateEnemyRange(game, start, start + ENEMIES_PER_JOB);
 }
 
-void collectSolarCells(Game *game, Player *player)
+// Players act one after another so two can't kill the same enemy
+void playerActionsJob(void *data, int index)
 {
-  // Check collision against all cells with player
+  Game *game = (Game *)data;
 
-  pthread_mutex_lock(&game->solarCellsMutex);
-  for (int i = 0; i < game->maxSolarCells; i++)
+  for (int i = 0; i < game->playerCount; i++)
   {
-    if (game->solarCells[i].active &&
-        CheckCollisionRecs(
-            (Rectangle){player->position.x - (float)player->size / 2,
-                        player->position.y - (float)player->size / 2,
-                        player->size, player->size},
-            (Rectangle){game->solarCells[i].position.x -
-                            (float)game->solarCells[i].size / 2,
-                        game->solarCells[i].position.y -
-                            (float)game->solarCells[i].size / 2,
-                        game->solarCells[i].size, game->solarCells[i].size}))
-    {
-
-      // Remove Solar Cell
-      game->solarCellsCollected++;
-      playMultiSound(game->sound->pickup);
-      removeSolarCell(game, i);
-    }
+    applyPlayerActions(game, &game->players[i], game->playerInputs[i]);
   }
-  pthread_mutex_unlock(&game->solarCellsMutex);
-};
+}
 
-void drawEnemies(Game *game)
+void indexEnemiesJob(void *data, int index)
 {
-  // Drawing all enemies
-  for (int i = 0; i < game->maxEnemies; i++)
-  {
-    if (game->enemies[i].active)
-    {
+  indexEnemies((Game *)data);
+}
 
-      Rectangle sourceRect = {
-          0, 0,
-          // game->enemies[i].flipDir
-          1 * game->zombieTexture.width, // Flip width if direction is negative
-          game->zombieTexture.height};
-
-      // DrawTexturePro(
-      //     game->playerTextures[i % 2], sourceRect,
-      //     (Rectangle){
-      //         game->players[i].position.x - (float)game->players[i].size / 2,
-      //         game->players[i].position.y - (float)game->players[i].size / 2,
-      //         game->players[i].size, game->players[i].size},
-      // (Vector2){0, 0}, 0.0f, WHITE);
-
-      DrawTexturePro(
-          game->zombieTexture, sourceRect,
-          (Rectangle){
-              game->enemies[i].position.x - (float)game->enemies[i].size / 2,
-              game->enemies[i].position.y - (float)game->enemies[i].size / 2,
-              game->enemies[i].size, game->enemies[i].size},
-          (Vector2){0, 0}, 0.0f, WHITE);
-    }
-  }
+void updateProjectilesJob(void *data, int index)
+{
+  Game *game = (Game *)data;
+  int start = index * PROJECTILES_PER_JOB;
+
+  updateProjectileRange(game, start, start + PROJECTILES_PER_JOB);
 }
 
-void drawSolarChargers(Game *game)
+void resolveProjectileHitsJob(void *data, int index)
 {
-  for (int i = 0; i < game->maxSolarChargers; i++)
-  {
-    if (game->solarChargers[i].active)
-    {
-      DrawRectangleRounded(
-          (Rectangle){game->solarChargers[i].position.x -
-                          (float)game->solarChargers[i].width / 4,
-                      game->solarChargers[i].position.y -
-                          (float)game->solarChargers[i].height / 4,
-                      game->solarChargers[i].width,
-                      game->solarChargers[i].height},
-          0, 1, (Color){50, 50, 50, 255});
-    }
-  }
+  resolveProjectileHits((Game *)data);
 }
 
-bool playing = false;
+void chargeBatteryJob(void *data, int index)
+{
+  Game *game = (Game *)data;
+  int start = index * CHARGERS_PER_JOB;
+
+  chargeBattery(game, start, start + CHARGERS_PER_JOB);
+}
 
-void updateEnemies(Game *game)
+// Records the health bars, battery and stats drawn over the viewports
+void recordHudCommands(Game *game, RenderPrep *prep)
 {
-  for (int i = 0; i < game->maxEnemies; i++)
+  prep->commandCount = 0;
+
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    // Skip inactive enemies
-    if (!game->enemies[i].active)
-      continue;
+    Rectangle screenRect = game->viewports[i].screenRect;
+    Player *player = game->viewports[i].player;
 
-    Player *closestPlayer = NULL;
-    float shortestDistance = INT_MAX;
+    lockTracedMutex(&player->mutex, "player");
+    float health = player->health;
+    pthread_mutex_unlock(&player->mutex);
 
-    for (int j = 0; j < game->playerCount; j++)
-    {
-      pthread_mutex_lock(&game->players[j].mutex);
+    float healthPercent = health / 100.0f;
+    Color healthColor =
+        healthPercent > 0.6f ? GREEN : (healthPercent > 0.3f ? YELLOW : RED);
 
-      float distance = getDistanceBetweenVectors(game->enemies[i].position,
-                                                 game->players[j].position);
+    Rectangle healthBarBack = {
+        screenRect.x + screenRect.width / 2 - 160,
+        screenRect.y + screenRect.height - 40, 340, 20};
+    pushRenderRect(prep, healthBarBack, GRAY);
+    pushRenderRect(prep,
+                   (Rectangle){healthBarBack.x, healthBarBack.y,
+                               healthBarBack.width * healthPercent,
+                               healthBarBack.height},
+                   healthColor);
 
-      if (distance < shortestDistance)
-      {
-        shortestDistance = distance;
-        closestPlayer = &game->players[j];
-      }
-      pthread_mutex_unlock(&game->players[j].mutex);
-    };
+    char playerHealthText[128];
+    int playerHealthFontSize = 18;
+    sprintf(playerHealthText, "%.1f", health);
 
-    // if close enough to player, stop and give him damage
-    if (shortestDistance < (float)closestPlayer->size)
-    {
-      pthread_mutex_lock(&closestPlayer->mutex);
-      closestPlayer->health -= (float)game->enemies[i].damage / game->targetFPS;
-      pthread_mutex_unlock(&closestPlayer->mutex);
+    pushRenderText(prep, playerHealthText,
+                   screenRect.x + screenRect.width / 2,
+                   screenRect.y + screenRect.height - playerHealthFontSize -
+                       screenRect.height * 0.025,
+                   playerHealthFontSize, WHITE, true);
+  }
 
-      continue;
-    }
+  // Battery Bar
+  float batteryPercent = game->battery / 100.0f;
+  if (batteryPercent > 1.0f)
+    batteryPercent = 1.0f;
+  if (batteryPercent < 0.0f)
+    batteryPercent = 0.0f;
 
-    // Getting direction to the closest player
-    Vector2 direction = getDirectionVector2s(game->enemies[i].position,
-                                             closestPlayer->position);
+  Rectangle batteryBarBack = {0, 0, GetScreenWidth(), 20};
+  pushRenderRect(prep, batteryBarBack, GRAY);
 
-    Vector2 velocity = (Vector2){direction.x * game->enemies[i].speed,
-                                 direction.y * game->enemies[i].speed};
+  Color batteryColor =
+      batteryPercent > 0.6f ? GREEN : (batteryPercent > 0.3f ? YELLOW : RED);
 
-    game->enemies[i].position.x += velocity.x;
-    game->enemies[i].position.y += velocity.y;
+  pushRenderRect(prep,
+                 (Rectangle){batteryBarBack.x, batteryBarBack.y,
+                             batteryBarBack.width * batteryPercent,
+                             batteryBarBack.height},
+                 batteryColor);
 
-    // Check for collision with other enemies
-    bool colliding = false;
-    for (int j = 0; j < game->maxEnemies; j++)
-    {
+  char batteryPercentText[128];
+  sprintf(batteryPercentText, "%.1f volts", game->battery);
+  pushRenderText(prep, batteryPercentText, GetScreenWidth() / 2, 1, 18, WHITE,
+                 true);
 
-      // Skip inactive enemies
-      if (!game->enemies[j].active)
-        continue;
+  // Enemies left, solar cells collected, wave number and time to next wave
+  lockTracedMutex(&game->enemyCountMutex, "enemy count");
+  int enemiesLeft = game->enemyCount;
+  pthread_mutex_unlock(&game->enemyCountMutex);
 
-      // Check sound
-      if (!IsSoundPlaying(game->enemies[i].sound))
-      {
-        game->enemies[i].sound =
-            LoadSoundAlias(game->sound->zombie[rand() % 7]);
-        SetSoundVolume(game->enemies[i].sound, 0.5);
-        PlaySound(game->enemies[i].sound);
-      }
+  int secondsToNextWave =
+      ((game->waves[game->currentWave].waitTime * game->targetFPS +
+        game->lastWaveFrame) -
+       game->frameCount) /
+      game->targetFPS;
 
-      if (i != j &&
-          CheckCollisionCircles(
-              game->enemies[i].position, (float)game->enemies[i].size * 0.55,
-              game->enemies[j].position, (float)game->enemies[j].size * 0.55))
-      {
-        // If collission is detected, push the current enemy in the opposite
-        // direction as the player
-        colliding = true;
-        direction = getDirectionVector2s(game->enemies[j].position,
-                                         game->enemies[i].position);
-        // direction = normalizeVector2(
-        //     (Vector2){(float)(rand() % 20 - 10), (float)(rand() % 20 - 10)});
-
-        game->enemies[i].position.x +=
-            direction.x * (game->enemies[i].speed * 0.5);
-        game->enemies[i].position.y +=
-            direction.y * (game->enemies[i].speed * 0.5);
-      }
-    }
-    // Undo the move made earlier if colliding
-    if (colliding)
-    {
-      game->enemies[i].position.x -= velocity.x;
-      game->enemies[i].position.y -= velocity.y;
-    }
+  char statsText[4][128];
+  sprintf(statsText[0], "Enemies Alive: %d", enemiesLeft);
+  sprintf(statsText[1], "Solar Cells: %d", game->solarCellsCollected);
+  sprintf(statsText[2], "Current Wave: %d", game->currentWave);
+  if (secondsToNextWave >= 0)
+  {
+    sprintf(statsText[3], "Time to next wave: %ds", secondsToNextWave);
+  }
+  else
+  {
+    sprintf(statsText[3], "Time to next wave: Inifinity");
   }
-}
 
-void addEnemies(Game *game, int n)
-{
-  int i = 0;
-  pthread_mutex_lock(&game->enemyCountMutex);
-  while (n > 0 && game->enemyCount <= game->maxEnemies &&
-         i < game->maxEnemies)
+  int statsFontSize = 25;
+  for (int i = 0; i < 4; i++)
   {
+    pushRenderText(prep, statsText[i], GetScreenWidth() * 0.01,
+                   batteryBarBack.height + 30 + statsFontSize * i,
+                   statsFontSize, WHITE, false);
+  }
 
-    if (!game->enemies[i].active)
+  // Memory overlay, toggled with F3
+  if (game->showMemoryOverlay)
+  {
+    int memoryFontSize = 18;
+    float memoryY = batteryBarBack.height + 40 + statsFontSize * 4;
+    for (int i = 0; i < MEMORY_TAG_COUNT; i++)
     {
-      game->enemies[i].active = true;
-      game->enemies[i].size = 70;
-      game->enemies[i].color = RED;
-      game->enemies[i].damage = 5;
-      game->enemies[i].speed = 200 / game->targetFPS;
-      game->enemies[i].position =
-          (Vector2){((rand() % game->mapSize) - (float)game->mapSize / 2),
-                    (rand() % game->mapSize) - (float)game->mapSize / 2};
-
-      printf("playing sound\n");
-
-      game->enemyCount++;
-      n--;
+      MemoryTagStats *stats = &memoryTracker.tags[i];
+      char memoryText[128];
+      sprintf(memoryText, "%-9s %8lld KB  peak %8lld KB", memoryTagNames[i],
+              atomic_load(&stats->liveBytes) / 1024,
+              atomic_load(&stats->peakBytes) / 1024);
+      pushRenderText(prep, memoryText, GetScreenWidth() * 0.01,
+                     memoryY + memoryFontSize * i, memoryFontSize, LIGHTGRAY,
+                     false);
     }
 
-    i++;
+    char latencyText[128];
+    sprintf(latencyText, "input to present p50 %.1fms p95 %.1fms p99 %.1fms%s",
+            game->latency.p50 * 1000, game->latency.p95 * 1000,
+            game->latency.p99 * 1000,
+            game->latency.lowLatency ? " (low latency)" : "");
+    pushRenderText(prep, latencyText, GetScreenWidth() * 0.01,
+                   memoryY + memoryFontSize * MEMORY_TAG_COUNT, memoryFontSize,
+                   LIGHTGRAY, false);
   }
 
-  pthread_mutex_unlock(&game->enemyCountMutex);
+  // Message shown to player
+  int messageFontSize = 45;
+  int messageWidth = MeasureText(game->message, messageFontSize);
+
+  pushRenderRect(prep,
+                 (Rectangle){GetScreenWidth() * 0.5 - messageWidth * 0.5,
+                             GetScreenHeight() * 0.5 - messageFontSize * 0.5,
+                             messageWidth, messageFontSize},
+                 (Color){0, 0, 0, 255 * game->messageOpacity});
+  pushRenderText(prep, game->message, GetScreenWidth() * 0.5,
+                 GetScreenHeight() * 0.5 - messageFontSize * 0.5,
+                 messageFontSize,
+                 (Color){255, 255, 255, 255 * game->messageOpacity}, true);
 }
 
-void killEnemy(Game *game, int enemyIndex)
+void prepareRenderFrameJob(void *data, int index)
 {
-  game->enemies[enemyIndex].active = false;
-  StopSound(game->enemies[enemyIndex].sound);
-  pthread_mutex_lock(&game->enemyCountMutex);
-  game->enemyCount--;
-  pthread_mutex_unlock(&game->enemyCountMutex);
+  Game *game = (Game *)data;
+  prepareRenderFrame(game, game->nextRenderPrep);
 }
 
-void handleShoot(Game *game, Player *player)
+void recordHudJob(void *data, int index)
 {
-  float enemyHealth = 0.1;
-
-  if (game->battery > enemyHealth)
-  {
-
-    pthread_mutex_lock(&player->mutex);
-    int closestEnemy = getClosestEnemyIndex(game, player->position);
-    pthread_mutex_unlock(&player->mutex);
-
-    if (closestEnemy != -1 &&
-        getDistanceBetweenVectors(game->enemies[closestEnemy].position,
-                                  player->position) <= game->gunRange)
-    {
-      pthread_mutex_lock(&game->batteryMutex);
+  Game *game = (Game *)data;
+  recordHudCommands(game, game->nextRenderPrep);
+}
 
-      playMultiSound(game->sound->shoot);
-      killEnemy(game, closestEnemy);
-      game->battery -= enemyHealth;
-      playMultiSound(game->sound->shoot);
+// The main thread draws one buffer while the simulation fills the other
+void swapRenderPreps(Game *game)
+{
+  RenderPrep *drawn = game->renderPrep;
+  game->renderPrep = game->nextRenderPrep;
+  game->nextRenderPrep = drawn;
+}
 
-      pthread_mutex_unlock(&game->batteryMutex);
-    }
-  }
-  else
-  {
-    playMultiSound(game->sound->noAmmo);
-    showMessage(game, "[!] Not enough battery, make solar panels", 20);
-  }
+// Starts the next tick of the simulation as a task graph:
+// players -> enemies -> enemy indexing -> actions -> projectiles -> hits,
+// with energy after actions, render prep after hits and the HUD last.
+// Nothing else may touch the game until waitForJobs returns.
+void submitFrameJobs(Game *game)
+{
+  JobSystem *jobs = game->jobs;
+
+  Job *players = createJob(jobs, "move players", movePlayerJob, game,
+                           game->playerCount);
+  Job *enemies =
+      createJob(jobs, "update enemies", updateEnemiesJob, game,
+                (game->enemies.liveCount + ENEMIES_PER_JOB - 1) /
+                    ENEMIES_PER_JOB);
+  Job *actions = createJob(jobs, "player actions", playerActionsJob, game, 1);
+  Job *enemyIndex = createJob(jobs, "index enemies", indexEnemiesJob, game, 1);
+
+  // Each player fires at most one bolt per tick
+  Job *projectiles =
+      createJob(jobs, "update projectiles", updateProjectilesJob, game,
+                (game->projectiles.liveCount + game->playerCount +
+                 PROJECTILES_PER_JOB - 1) /
+                    PROJECTILES_PER_JOB);
+  Job *hits =
+      createJob(jobs, "projectile hits", resolveProjectileHitsJob, game, 1);
+
+  // Chargers built by this tick's actions charge straight away, so size
+  // energy for a full set
+  Job *energy = createJob(jobs, "charge battery", chargeBatteryJob, game,
+                          (game->maxSolarChargers + CHARGERS_PER_JOB - 1) /
+                              CHARGERS_PER_JOB);
+  Job *renderPrep =
+      createJob(jobs, "render prep", prepareRenderFrameJob, game, 1);
+  Job *hud = createJob(jobs, "hud", recordHudJob, game, 1);
+
+  addJobDependency(enemies, players);
+  addJobDependency(enemyIndex, enemies);
+  addJobDependency(actions, enemyIndex); // aiming looks through the grid
+  addJobDependency(projectiles, actions);
+  addJobDependency(hits, projectiles);
+  addJobDependency(energy, actions);
+  addJobDependency(renderPrep, hits);
+  addJobDependency(hud, energy);
+  addJobDependency(hud, hits);
+
+  submitJob(jobs, players);
+  submitJob(jobs, enemies);
+  submitJob(jobs, actions);
+  submitJob(jobs, enemyIndex);
+  submitJob(jobs, projectiles);
+  submitJob(jobs, hits);
+  submitJob(jobs, energy);
+  submitJob(jobs, renderPrep);
+  submitJob(jobs, hud);
 }
 
-void *updatePlayer(void *arg)
+// Keeps every zombie groaning, audio is only touched from the main thread
+void updateZombieSounds(Game *game)
 {
-  ViewportThreadArgument *args = (ViewportThreadArgument *)arg;
-  Game *game = args->game;
-  int viewportIndex = args->viewportIndex;
-  Viewport *viewport = &game->viewports[viewportIndex];
-  int localFrameCount = -1;
-  free(arg);
+  if (game->headless)
+    return;
 
-  while (!game->isQuitting)
+  EntityArchetype *enemies = &game->enemies;
+
+  for (int i = 0; i < enemies->liveCount; i++)
   {
-    // Wait for this thread's turn
-    sem_wait(&viewport->inputSemaphore);
+    int slot = enemies->live[i];
+    Sound *sound = &enemies->sounds[slot];
 
-    // Get current frame count (with mutex protection)
-    int currentFrame = game->frameCount;
+    // Only the ones on screen groan, they go quiet once they are far away
+    if (game->enemyTiers[slot] != ENEMY_TIER_NEAR)
+      continue;
 
-    // Skip processing if we already handled this frame
-    if (localFrameCount == currentFrame)
+    if (!IsSoundPlaying(*sound))
     {
-      sem_post(&game->viewports[(viewportIndex + 1) % game->playerCount]
-                    .inputSemaphore);
-      continue;
+      // Done with the last groan's alias
+      if (sound->frameCount > 0)
+        UnloadSoundAlias(*sound);
+
+      *sound = LoadSoundAlias(game->sound->zombie[gameRandom(game) % 7]);
+      SetSoundVolume(*sound, 0.5);
+      PlaySound(*sound);
     }
+  }
+}
 
-    localFrameCount = currentFrame;
+void drawSprite(Game *game, RenderSprite *sprite)
+{
+  switch (sprite->layer)
+  {
+  case RENDER_LAYER_CHARGER:
+    DrawRectangleRounded(sprite->rect, 0, 1, (Color){50, 50, 50, 255});
+    break;
 
-    // Process input
-    Vector2 direction = {0, 0};
-    const int controlScheme = viewportIndex % 2; // Use 2 control schemes
+  case RENDER_LAYER_CELL:
+    DrawRectangleRounded(sprite->rect, 1, 1, GRAY);
+    break;
 
-    // Movement controls (using simplified array access)
-    if (IsKeyDown(controls[controlScheme][0]))
-      direction.y = -1; // Up
-    if (IsKeyDown(controls[controlScheme][1]))
-    {
-      direction.x = -1; // Left
-      viewport->player->flipDir = -1;
-    }
-    if (IsKeyDown(controls[controlScheme][2]))
-      direction.y = 1; // Down
-    if (IsKeyDown(controls[controlScheme][3]))
-    {
-      direction.x = 1; // Right
-      viewport->player->flipDir = 1;
-    }
+  case RENDER_LAYER_ENEMY:
+  {
+    Rectangle sourceRect = {0, 0, game->zombieTexture.width,
+                            game->zombieTexture.height};
 
-    // Build Solar Charger Small
-    if (IsKeyPressed(controls[controlScheme][5]))
-    {
-      pthread_mutex_lock(&viewport->player->mutex);
+    DrawTexturePro(game->zombieTexture, sourceRect, sprite->rect,
+                   (Vector2){0, 0}, 0.0f, WHITE);
+    break;
+  }
 
-      buildSolarCharger(game, viewport->player->position, 1);
+  case RENDER_LAYER_PROJECTILE:
+    DrawRectangleRounded(sprite->rect, 1, 4, YELLOW);
+    break;
 
-      pthread_mutex_unlock(&viewport->player->mutex);
-    }
+  case RENDER_LAYER_PLAYER:
+  {
+    Texture2D texture = game->playerTextures[sprite->index % 2];
 
-    // Build Solar Charger Large
-    if (IsKeyPressed(controls[controlScheme][6]))
-    {
-      pthread_mutex_lock(&viewport->player->mutex);
+    // Flip width if direction is negative
+    Rectangle sourceRect = {0, 0, sprite->flipDir * texture.width,
+                            texture.height};
 
-      buildSolarCharger(game, viewport->player->position, 2);
+    // Players past the first two reuse a texture, tinted with their colour
+    Color tint = sprite->index < 2 ? WHITE : game->players[sprite->index].color;
 
-      pthread_mutex_unlock(&viewport->player->mutex);
-    }
+    DrawTexturePro(texture, sourceRect, sprite->rect, (Vector2){0, 0}, 0.0f,
+                   tint);
+    break;
+  }
+  }
+}
 
-    // Shoot action
-    if (IsKeyPressed(controls[controlScheme][4]))
-    {
+// Whether a render cell could hold an enemy close enough to some player to
+// still be drawn as a sprite when zoomed out
+bool isRenderCellNearPlayer(Game *game, int cellX, int cellY)
+{
+  RenderPrep *prep = game->renderPrep;
+  float range = RENDER_DENSITY_SPRITE_RANGE + prep->cellSize / 2;
 
-      handleShoot(game, viewport->player);
-    }
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Vector2 position = prep->playerPositions[i];
+    float centerX = prep->origin.x + (cellX + 0.5f) * prep->cellSize;
+    float centerY = prep->origin.y + (cellY + 0.5f) * prep->cellSize;
 
-    // Camera controls (global)
-    if (viewportIndex == 0)
-    { // Only process these once
-      if (IsKeyPressed(KEY_EQUAL))
-      {
-        for (int i = 0; i < game->playerCount; i++)
-        {
-          game->viewports[i].camera->zoom += 0.25;
-        }
-      }
-      if (IsKeyPressed(KEY_MINUS))
-      {
-        for (int i = 0; i < game->playerCount; i++)
-        {
-          game->viewports[i].camera->zoom -= 0.25;
-        }
-      }
-    }
+    if (fabsf(centerX - position.x) < range &&
+        fabsf(centerY - position.y) < range)
+      return true;
+  }
 
-    // Check if solar cell collected
-    collectSolarCells(game, viewport->player);
+  return false;
+}
 
-    // Apply movement if game isn't paused
-    if (!game->paused && (direction.x != 0 || direction.y != 0))
-    {
-      direction = normalizeVector2(direction);
+// The enemy heat map stretched over the zoomed out views in one draw
+void drawEnemyDensity(Game *game)
+{
+  RenderPrep *prep = game->renderPrep;
+  Texture2D texture = game->densityTexture;
+
+  DrawTexturePro(texture,
+                 (Rectangle){0, 0, prep->densityColumns, prep->densityRows},
+                 (Rectangle){prep->densityOrigin.x, prep->densityOrigin.y,
+                             prep->densityColumns * prep->densityCellSize,
+                             prep->densityRows * prep->densityCellSize},
+                 (Vector2){0, 0}, 0.0f, WHITE);
+}
 
-      Vector2 velocity = {direction.x * viewport->player->speed,
-                          direction.y * viewport->player->speed};
+// Draws the sprites prepared this frame that fall inside the viewport.
+// Zoomed out, enemies away from the players are left to the heat map.
+void drawVisibleSprites(Game *game, Viewport *viewport, Camera2D camera)
+{
+  int minX, minY, maxX, maxY;
+  getVisibleRenderCells(game->renderPrep, camera,
+                        viewport->renderTexture->texture.width,
+                        viewport->renderTexture->texture.height, &minX, &minY,
+                        &maxX, &maxY);
 
-      int boundx = game->mapSize / 2, boundy = game->mapSize / 2;
+  bool density = isDensityViewport(viewport);
 
-      if (velocity.x < 0 && viewport->player->position.x < -boundx)
-      {
-        velocity.x = 0;
-      }
+  for (int layer = 0; layer < RENDER_LAYER_COUNT; layer++)
+  {
+    bool nearOnly = density && layer == RENDER_LAYER_ENEMY;
+    if (nearOnly)
+      drawEnemyDensity(game);
 
-      if (velocity.x > 0 && viewport->player->position.x > boundx)
+    for (int cellY = minY; cellY <= maxY; cellY++)
+    {
+      for (int cellX = minX; cellX <= maxX; cellX++)
       {
-        velocity.x = 0;
-      }
+        if (nearOnly && !isRenderCellNearPlayer(game, cellX, cellY))
+          continue;
 
-      if (velocity.y < 0 && viewport->player->position.y < -boundy)
-      {
-        velocity.y = 0;
-      }
+        int count;
+        RenderSprite *sprites = getRenderCellSprites(game->renderPrep, layer,
+                                                     cellX, cellY, &count);
 
-      if (velocity.y > 0 && viewport->player->position.y > boundy)
-      {
-        velocity.y = 0;
+        for (int i = 0; i < count; i++)
+        {
+          drawSprite(game, &sprites[i]);
+        }
       }
-
-      pthread_mutex_lock(&viewport->player->mutex);
-      viewport->player->position.x += velocity.x;
-      viewport->player->position.y += velocity.y;
-
-      pthread_mutex_unlock(&viewport->player->mutex);
     }
-
-    // Pass control to next thread
-    sem_post(&game->viewports[(viewportIndex + 1) % game->playerCount]
-                  .inputSemaphore);
-  }
-
-  return NULL;
-}
-
-void drawPlayers(Game *game)
-{
-  for (int i = 0; i < game->playerCount; i++)
-  {
-    pthread_mutex_lock(&game->players[i].mutex);
-
-    float direction = game->players[i].position.x < 0 ? -1.0f : 1.0f;
-
-    Rectangle sourceRect = {
-        0, 0,
-        game->players[i].flipDir *
-            game->playerTextures[i % 2]
-                .width, // Flip width if direction is negative
-        game->playerTextures[i % 2].height};
-
-    DrawTexturePro(
-        game->playerTextures[i % 2], sourceRect,
-        (Rectangle){
-            game->players[i].position.x - (float)game->players[i].size / 2,
-            game->players[i].position.y - (float)game->players[i].size / 2,
-            game->players[i].size, game->players[i].size},
-        (Vector2){0, 0}, 0.0f, WHITE);
-
-    pthread_mutex_unlock(&game->players[i].mutex);
   }
 }
 
@@ -848,68 +862,55 @@ void drawMap(Game *game)
                      game->mapSize, GREEN);
 }
 
-void win(Game *game)
+// Renders the world into each viewport's render texture
+void drawViewports(Game *game)
 {
-  game->paused = true;
-  game->gameWon = true;
-}
-
-void handleGameOver(Game *game)
-{
-  for (int i = 0; i < game->playerCount; i++)
+  // The heat map is uploaded once a frame and only while it is on screen.
+  // A tick prepared before zooming out has none yet.
+  RenderPrep *prep = game->renderPrep;
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    if (game->players[i].health < 0)
+    if (isDensityViewport(&game->viewports[i]) && prep->densityColumns > 0)
     {
-      game->paused = true;
-      game->gameOver = true;
+      UpdateTextureRec(game->densityTexture,
+                       (Rectangle){0, 0, prep->densityColumns,
+                                   prep->densityRows},
+                       prep->densityPixels);
+      break;
     }
   }
-}
 
-void generateEnemies(Game *game)
-{
-  if (game->currentWave < game->numWaves)
-  {
-    if (game->frameCount >
-        game->lastWaveFrame +
-            game->waves[game->currentWave].waitTime * game->targetFPS)
-    {
+  bool timeGpu = isGpuTimingFrame(&game->resolution);
 
-      // Unleash the enemies for this wave
-      char message[256];
-      sprintf(message, "WAVE %d begins!", game->currentWave);
-      showMessage(game, message, 45);
-
-      addEnemies(game, game->waves[game->currentWave].numEnemies);
-      game->lastWaveFrame = game->frameCount;
-      game->currentWave++;
-    }
-  }
-  else
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    if (game->enemyCount <= 0)
-      win(game);
-  }
-}
 
-void draw(Game *game)
-{
+    Player *player = game->viewports[i].player;
+    int playerIndex = player - game->players;
 
-  // Drawing on every viewport
-  for (int i = 0; i < game->playerCount; i++)
-  {
+    // Updating camera to follow player, as of the prepared tick
+    Vector2 playerPosition = game->renderPrep->playerPositions[playerIndex];
+
+    game->viewports[i].camera->target =
+        (Vector2){(int)(playerPosition.x), (int)(playerPosition.y)};
 
-    // Updating camera to follow player
-    pthread_mutex_lock(&game->players[i].mutex);
-    game->viewports[i].camera->target = (Vector2){
-        (int)(game->players[i].position.x), (int)(game->players[i].position.y)};
-    pthread_mutex_unlock(&game->players[i].mutex);
+    // The render texture may be scaled down, so zoom out with it to keep
+    // the same view of the world
+    RenderTexture2D *renderTexture = game->viewports[i].renderTexture;
+    Camera2D camera = *game->viewports[i].camera;
+    camera.zoom *= game->viewports[i].resolutionScale;
+    camera.offset = (Vector2){(int)(renderTexture->texture.width / 2),
+                              (int)(renderTexture->texture.height / 2)};
 
     // Setting to draw on the viewport's RenderTexture
-    BeginTextureMode(*game->viewports[i].renderTexture);
+    BeginTextureMode(*renderTexture);
+
+    // Let the GPU finish earlier work so it isn't billed to this viewport
+    if (timeGpu)
+      waitForGpu();
 
     // Drawing with respect to the viewport's Camera
-    BeginMode2D(*game->viewports[i].camera);
+    BeginMode2D(camera);
 
     // Start from a clean slate
     ClearBackground(BLACK);
@@ -917,176 +918,227 @@ void draw(Game *game)
     // Draw Borders
     drawMap(game);
 
-    // Draw Solar Chargers
-    drawSolarChargers(game);
-
-    // Draw solar cells
-    drawSolarCells(game);
+    // Draw chargers, cells, enemies and players in view
+    drawVisibleSprites(game, &game->viewports[i], camera);
 
     // Draw aim line
-    drawAimLine(game, &game->players[i]);
-
-    // Draw all enemies
-    drawEnemies(game);
-
-    // Drawing all players
-    drawPlayers(game);
+    drawAimLine(game, playerIndex, playerPosition);
 
     EndMode2D();
 
-    // Draw player health
-    Rectangle healthBarBack = {
-        game->viewports[i].renderTexture->texture.width / 2 - 160,
-        game->viewports[i].renderTexture->texture.height - 40, 340, 20};
-    DrawRectangle(healthBarBack.x, healthBarBack.y, healthBarBack.width,
-                  healthBarBack.height, GRAY);
-    char playerHealthText[128];
-    int playerHealthFontSize = 18;
+    // What the GPU still has left once every draw is submitted is the part
+    // the render texture size decides
+    if (timeGpu)
+    {
+      double gpuStart = GetTime();
+      waitForGpu();
+      recordViewportRenderTime(&game->viewports[i], GetTime() - gpuStart);
+    }
 
-    pthread_mutex_lock(&game->players[i].mutex);
-    float healthPercent = game->players[i].health / 100.0f;
-    Color healthColor =
-        healthPercent > 0.6f ? GREEN : (healthPercent > 0.3f ? YELLOW : RED);
-    pthread_mutex_unlock(&game->players[i].mutex);
+    EndTextureMode();
+  }
+}
 
-    Rectangle healthBarFront = {healthBarBack.x, healthBarBack.y,
-                                healthBarBack.width * healthPercent,
-                                healthBarBack.height};
-    DrawRectangleRec(healthBarFront, healthColor);
+// The minimap in the top right corner of a viewport, with a dot per player.
+// The same few draws however many entities there are.
+void drawMinimap(Game *game, Rectangle screenRect)
+{
+  float size = fminf(screenRect.width, screenRect.height) * 0.2f;
+  Rectangle rect = {screenRect.x + screenRect.width - size - 10,
+                    screenRect.y + 30, size, size};
+  Texture2D texture = game->minimapTexture;
 
-    pthread_mutex_lock(&game->players[i].mutex);
-    sprintf(playerHealthText, "%.1f", game->players[i].health);
-    pthread_mutex_unlock(&game->players[i].mutex);
+  DrawTexturePro(texture, (Rectangle){0, 0, texture.width, texture.height},
+                 rect, (Vector2){0, 0}, 0.0f, WHITE);
+  DrawRectangleLinesEx(rect, 1, GRAY);
 
-    DrawText(playerHealthText,
-             game->viewports[i].renderTexture->texture.width / 2 -
-                 MeasureText(playerHealthText, playerHealthFontSize) / 2,
-             game->viewports[i].renderTexture->texture.height -
-                 playerHealthFontSize -
-                 game->viewports[i].renderTexture->texture.height * 0.025,
-             playerHealthFontSize, WHITE);
+  float scale = size / game->mapSize;
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    Vector2 position = game->renderPrep->playerPositions[i];
+    float x = (position.x + game->mapSize / 2.0f) * scale;
+    float y = (position.y + game->mapSize / 2.0f) * scale;
 
-    EndTextureMode();
+    DrawCircle(rect.x + fminf(fmaxf(x, 0), size),
+               rect.y + fminf(fmaxf(y, 0), size), 3, game->players[i].color);
   }
+}
+
+// Puts the viewports and the HUD together on the current render target
+void drawComposite(Game *game)
+{
+  double compositeStart = GetTime();
 
   ClearBackground(BLACK);
 
-  // Drawing the prepared viewports to a single screen sized rectangle
-  for (int i = 0; i < game->playerCount; i++)
+  // Drawing the prepared viewports to a single screen sized rectangle,
+  // upscaling the ones rendered below native resolution
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    DrawTextureRec(
-        game->viewports[i].renderTexture->texture,
-        (Rectangle){0, 0, game->viewports[i].renderTexture->texture.width,
-                    -game->viewports[i].renderTexture->texture.height},
-        (Vector2){i * (int)(GetScreenWidth() / game->playerCount), 0}, WHITE);
+    Texture2D texture = game->viewports[i].renderTexture->texture;
+
+    DrawTexturePro(texture,
+                   (Rectangle){0, 0, texture.width, -texture.height},
+                   game->viewports[i].screenRect, (Vector2){0, 0}, 0.0f,
+                   WHITE);
   }
 
   // Drawing line(s) between screens
-  for (int i = 1; i < game->playerCount; i++)
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    DrawRectangle(i * (int)(GetScreenWidth() / game->playerCount) - 2, 0, 4,
-                  GetScreenHeight(), WHITE);
-  }
+    Rectangle rect = game->viewports[i].screenRect;
 
-  // Battery Bar
-  float batteryPercent = game->battery / 100.0f;
-  if (batteryPercent > 1.0f)
-    batteryPercent = 1.0f;
-  if (batteryPercent < 0.0f)
-    batteryPercent = 0.0f;
-
-  Rectangle batteryBarBack = {0, 0, GetScreenWidth(), 20};
-  DrawRectangleRec(batteryBarBack, GRAY);
-
-  Color batteryColor =
-      batteryPercent > 0.6f ? GREEN : (batteryPercent > 0.3f ? YELLOW : RED);
+    if (rect.x > 0)
+      DrawRectangle(rect.x - 2, rect.y, 4, rect.height, WHITE);
+    if (rect.y > 0)
+      DrawRectangle(rect.x, rect.y - 2, rect.width, 4, WHITE);
+  }
 
-  Rectangle batteryBarFront = {batteryBarBack.x, batteryBarBack.y,
-                               batteryBarBack.width * batteryPercent,
-                               batteryBarBack.height};
-  DrawRectangleRec(batteryBarFront, batteryColor);
+  // Counts that haven't changed since last frame are already uploaded
+  updateMinimapTexture(&game->minimap, game->minimapTexture);
+  for (int i = 0; i < game->viewportCount; i++)
+  {
+    drawMinimap(game, game->viewports[i].screenRect);
+  }
 
-  char batteryPercentText[128];
-  sprintf(batteryPercentText, "%.1f volts", game->battery);
-  DrawText(batteryPercentText,
-           GetScreenWidth() / 2 - MeasureText(batteryPercentText, 18) / 2, 1,
-           18, WHITE);
+  // Health, battery, stats and message at native resolution
+  submitRenderCommands(game->renderPrep);
 
   // Draw FPS
-  DrawFPS(0, batteryBarBack.height + 5);
+  DrawFPS(0, 25);
 
-  // Draw enemies left
-  pthread_mutex_lock(&game->enemyCountMutex);
-  int enemiesLeft = game->enemyCount;
-  pthread_mutex_unlock(&game->enemyCountMutex);
+  recordCompositeTime(&game->resolution, GetTime() - compositeStart);
+}
+
+void draw(Game *game)
+{
+  drawViewports(game);
+  drawComposite(game);
+}
 
-  char enemiesAliveText[128];
-  sprintf(enemiesAliveText, "Enemies Alive: %d", enemiesLeft);
-  int enemiesAliveFontSize = 25;
+// Nothing moves while paused, so the frame is drawn once into pausedFrame
+// and only copied to the screen after that, under the menus
+void drawPausedFrame(Game *game)
+{
+  RenderTexture2D *frame = &game->pausedFrame;
 
-  DrawText(enemiesAliveText, GetScreenWidth() * 0.01,
-           batteryBarBack.height + 30, enemiesAliveFontSize, WHITE);
+  if (frame->texture.width != GetScreenWidth() ||
+      frame->texture.height != GetScreenHeight())
+  {
+    if (frame->id != 0)
+      UnloadRenderTexture(*frame);
+    *frame = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+    game->pausedFrameValid = false;
+  }
 
-  // Draw Solar Cells Collected
-  char solarCellsText[128];
-  sprintf(solarCellsText, "Solar Cells: %d", game->solarCellsCollected);
-  int solarCellsFontSize = 25;
+  if (!game->pausedFrameValid)
+  {
+    drawViewports(game);
 
-  DrawText(solarCellsText, GetScreenWidth() * 0.01,
-           batteryBarBack.height + 30 + enemiesAliveFontSize,
-           solarCellsFontSize, WHITE);
+    BeginTextureMode(*frame);
+    ClearBackground(BLACK);
+    drawComposite(game);
+    EndTextureMode();
 
-  // Draw wave number
-  char waveNumberText[128];
-  sprintf(waveNumberText, "Current Wave: %d", game->currentWave);
-  int waveNumberFontSize = 25;
+    game->pausedFrameValid = true;
+  }
 
-  DrawText(waveNumberText, GetScreenWidth() * 0.01,
-           batteryBarBack.height + 30 + enemiesAliveFontSize +
-               solarCellsFontSize,
-           waveNumberFontSize, WHITE);
+  ClearBackground(BLACK);
+  DrawTexturePro(frame->texture,
+                 (Rectangle){0, 0, frame->texture.width,
+                             -frame->texture.height},
+                 (Rectangle){0, 0, GetScreenWidth(), GetScreenHeight()},
+                 (Vector2){0, 0}, 0.0f, WHITE);
+}
 
-  // Draw Time to next wave
-  int secondsToNextWave =
-      ((game->waves[game->currentWave].waitTime * game->targetFPS +
-        game->lastWaveFrame) -
-       game->frameCount) /
-      game->targetFPS;
+// While paused the main loop only runs when there is input to handle, and
+// the workers are already asleep with no jobs to take
+void setWaitingForInput(Game *game, bool waiting)
+{
+  if (game->waitingForInput == waiting)
+    return;
 
-  char timeToNextWaveText[128];
-  if (secondsToNextWave >= 0)
+  game->waitingForInput = waiting;
+  if (waiting)
   {
-    sprintf(timeToNextWaveText, "Time to next wave: %ds", secondsToNextWave);
+    EnableEventWaiting();
   }
   else
   {
-    sprintf(timeToNextWaveText, "Time to next wave: Inifinity");
+    DisableEventWaiting();
+    game->pausedFrameValid = false;
   }
-  int timeToNextWaveFontSize = 25;
-
-  DrawText(timeToNextWaveText, GetScreenWidth() * 0.01,
-           batteryBarBack.height + 30 + enemiesAliveFontSize +
-               solarCellsFontSize + waveNumberFontSize,
-           timeToNextWaveFontSize, WHITE);
-
-  // Draw shown to player
-  drawMessage(game);
 }
 
-// In killViewports function:
 void killViewports(Game *game)
 {
   game->isQuitting = true;
-  for (int i = 0; i < game->playerCount; i++)
+  for (int i = 0; i < game->viewportCount; i++)
   {
-    pthread_join(game->viewports[i].thread, NULL);
     UnloadRenderTexture(*game->viewports[i].renderTexture);
-    sem_destroy(&game->viewports[i].inputSemaphore);
   }
 
-  // Unload player textures
+  destroyRenderPrep(game->renderPrep);
+  destroyRenderPrep(game->nextRenderPrep);
+  UnloadTexture(game->densityTexture);
+  UnloadTexture(game->minimapTexture);
+
+  // The cameras and render textures were allocated as one array each
+  trackedFree(game->viewports[0].camera);
+  trackedFree(game->viewports[0].renderTexture);
+  trackedFree(game->viewports);
+  game->viewports = NULL;
+}
+
+void unloadGameTextures(Game *game)
+{
   UnloadTexture(game->playerTextures[0]);
   UnloadTexture(game->playerTextures[1]);
+  UnloadTexture(game->zombieTexture);
+}
+
+// Releases whatever main set up, then reports anything left behind. Works
+// from any point of startup, after the simulation has stopped.
+void shutdownGame(Game *game)
+{
+  game->isQuitting = true;
+
+  // One last save of where the match stopped, the writer finishes it
+  if (game->saver != NULL)
+  {
+    if (game->players != NULL)
+    {
+      waitForSaveWriter(game->saver);
+      snapshotGame(game->saver, game);
+    }
+    destroySaveWriter(game->saver);
+    game->saver = NULL;
+  }
+
+  if (game->jobs != NULL)
+    destroyJobSystem(game->jobs);
+  if (game->viewports != NULL)
+    killViewports(game);
+  if (game->playerTextures[0].id != 0)
+    unloadGameTextures(game);
+  if (game->pausedFrame.id != 0)
+    UnloadRenderTexture(game->pausedFrame);
+  if (game->sound != NULL && !game->headless)
+    unloadGameSounds(game);
+
+  destroySimulation(game);
+  destroyGameEventQueue(game->events);
+
+  // Every thread that traced has been joined by now
+  if (isTracing())
+  {
+    stopTrace();
+    writeTrace(game->tracePath);
+  }
+  destroyTraceRecorder();
+
+  printLatencyReport(&game->latency);
+  printMemoryReport();
 }
 
 void drawMenuOptions(Game *game, int centerX, int startY, int fontSize, int buttonHeight, int buttonWidth, int buttonSpacing)
@@ -1125,6 +1177,48 @@ void drawMenuOptions(Game *game, int centerX, int startY, int fontSize, int butt
            fontSize, endGameColor);
 }
 
+void drawControlsMenu(Game *game)
+{
+  DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Fade(BLACK, 0.7));
+  int titleSize = GetScreenHeight() * 0.05;
+  int centerX = GetScreenWidth() / 2;
+
+  DrawText("CONTROLS", centerX - MeasureText("CONTROLS", titleSize) / 2,
+           GetScreenHeight() * 0.1, titleSize, WHITE);
+
+  // One column per player, wrapping after four
+  int columns = game->playerCount < 4 ? game->playerCount : 4;
+  int rows = (game->playerCount + columns - 1) / columns;
+  int fontSize = GetScreenHeight() * (rows > 1 ? 0.025 : 0.035);
+  int columnWidth = GetScreenWidth() / columns;
+  int rowHeight = GetScreenHeight() * 0.6 / rows;
+
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    int columnX = (i % columns) * columnWidth + columnWidth / 2;
+    int rowY = GetScreenHeight() * 0.22 + (i / columns) * rowHeight;
+    Color color = game->players[i].color;
+
+    char title[32];
+    sprintf(title, "PLAYER %d:", i + 1);
+    DrawText(title, columnX - MeasureText(title, fontSize) / 2, rowY,
+             fontSize, color);
+
+    for (int line = 0; line < 3; line++)
+    {
+      const char *text = controlDescriptions[i][line];
+      DrawText(text, columnX - MeasureText(text, fontSize) / 2,
+               rowY + (line + 1) * fontSize * 1.4, fontSize, color);
+    }
+  }
+
+  // Back
+  fontSize = GetScreenHeight() * 0.04;
+  DrawText("Press BackSpace to go back",
+           centerX - MeasureText("Press BackSpace to go back", fontSize) / 2,
+           GetScreenHeight() * 0.85, fontSize, YELLOW);
+}
+
 void handleMenuSelection(Game *game)
 {
   // Handling Selection
@@ -1133,35 +1227,8 @@ void handleMenuSelection(Game *game)
     // Restart
     if (game->pauseMenuSelection == 0)
     {
-      game->paused = false;
-      game->currentWave = 0;
-      game->lastWaveFrame = game->frameCount;
-      game->battery = 0;
-      game->solarCellsCollected = 0;
-      game->enemyCount = 0;
-      game->gameOver = false;
-      game->gameWon = false;
-
-      for (int i = 0; i < game->playerCount; i++)
-      {
-        game->players[i].health = 100;
-        game->players[i].position =
-            (Vector2){0 + i * (20 + game->players[i].size), 0};
-      }
-      for (int i = 0; i < game->maxEnemies; i++)
-      {
-        game->enemies[i].active = false;
-      }
-      for (int i = 0; i < game->maxSolarChargers; i++)
-      {
-        game->solarChargers[i].active = false;
-      }
-      for (int i = 0; i < game->maxSolarCells; i++)
-      {
-        game->solarCells[i].active = false;
-      }
-
-      generateSolarCells(&game);
+      restartGame(game);
+      playMusic(game->sound->music);
     }
     // Controls
     else if (game->pauseMenuSelection == 1)
@@ -1177,184 +1244,497 @@ void handleMenuSelection(Game *game)
   }
 }
 
-int main(int argc, char **args)
+// Low latency mode paces frames itself, see latchInputs
+void setLowLatencyMode(Game *game, bool enabled)
 {
+  game->latency.lowLatency = enabled;
+  SetTargetFPS(enabled ? 0 : game->targetFPS);
+}
 
-  srand(time(NULL));
-  InitWindow(0, 0, "Thread Wars");
-  InitAudioDevice();
+// Keys that act on the whole game rather than a player
+void handleHotkeys(Game *game)
+{
+  // Pausing
+  if ((IsKeyPressed(KEY_P) || IsKeyPressed(KEY_ESCAPE)) && !game->gameOver &&
+      !game->gameWon)
+  {
+    game->paused = !game->paused;
+    if (game->paused)
+    {
+      pauseMusic(game->sound->music);
+      game->showPauseMenu = game->paused;
+      game->showControlsMenu = false;
+      game->pauseMenuSelection = 0;
+    }
+    else
+    {
+      playMusic(game->sound->music);
+    }
+  }
 
-  if (!IsWindowFullscreen())
+  if (IsKeyPressed(KEY_F3))
   {
-    ToggleFullscreen();
+    game->showMemoryOverlay = !game->showMemoryOverlay;
+    game->pausedFrameValid = false;
   }
 
-  Game game;
+  if (IsKeyPressed(KEY_F4))
+  {
+    setLowLatencyMode(game, !game->latency.lowLatency);
+  }
 
-  game.playerCount = 2;
+  // Between ticks, so the trace ends on whole frames
+  if (IsKeyPressed(KEY_F5))
+  {
+    toggleTrace(game->tracePath);
+  }
 
-  sprintf(game.message, "");
-  game.messageDuration = 1;
+  // Adding enemies
+  if (IsKeyPressed(KEY_BACKSPACE))
+  {
+    addEnemies(game, 5);
+  }
 
-  game.gunRange = 300;
+  handleZoomKeys(game);
+}
 
-  game.maxEnemies = 300;
-  game.enemyCount = 0;
+// Sleeps until just before the next frame has to start, then polls input
+// again so the tick sees the freshest keys. Returns false while paused,
+// where it only paces the frame so the menus keep the last poll's keys.
+bool latchInputs(Game *game, double lastPresentTime)
+{
+  double latchTime =
+      getLatchTime(&game->latency, lastPresentTime, 1.0f / game->targetFPS);
 
-  game.solarCells = 0;
-  game.maxSolarCells = 100;
-  game.solarCellsCollected = 0;
+  // Paused frames wait for input in EndDrawing instead
+  if (game->paused)
+    return false;
 
-  game.maxSolarChargers = 300;
-  game.numSolarChargesComputers = 5;
+  // Polling again forgets key presses nobody has read yet, so use them now
+  sampleInputs(game);
+  handleHotkeys(game);
 
-  game.battery = 0;
+  if (latchTime > GetTime())
+    WaitTime(latchTime - GetTime());
 
-  game.mapSize = 2000;
+  PollInputEvents();
+  game->latency.pollTime = GetTime();
 
-  game.targetFPS = 60;
-  game.paused = false;
-  game.isQuitting = false;
-  game.gameOver = false;
-  game.gameWon = false;
+  for (int i = 0; i < game->playerCount; i++)
+  {
+    PlayerInput input = samplePlayerInput(i % MAX_PLAYERS);
+    input.pressed |= game->playerInputs[i].pressed;
+    game->playerInputs[i] = input;
+  }
+  game->inputTime = game->latency.pollTime;
 
-  game.numWaves = 3;
-  game.currentWave = 0;
+  return true;
+}
 
-  game.pauseMenuSelection = 0;
-  game.showControlsMenu = false;
-  game.showPauseMenu = false;
+// Runs the match without a window, clients only ever see snapshots
+void runServer(Game *game, int port, char *loadPath)
+{
+  game->headless = true;
+  initializeSimulation(game);
+  if (loadPath != NULL)
+    loadGame(game, loadPath);
 
-  initGameSounds(&game);
-  initializeWaves(&game);
-  initializePlayers(&game);
-  initializeEnemies(&game);
-  initializeSolarChargers(&game);
-  initializeViewports(&game);
-  initializeSolarCells(&game);
+  NetServer *server = createNetServer(game, port);
+  if (server == NULL)
+    return;
 
-  pthread_mutex_init(&game.enemyCountMutex, NULL);
-  pthread_mutex_init(&game.batteryMutex, NULL);
-  pthread_mutex_init(&game.solarCellsMutex, NULL);
+  printf("Serving %d players on port %d\n", game->playerCount, port);
 
-  SetTargetFPS(game.targetFPS);
+  double tickTime = 1.0 / game->targetFPS;
+  double nextTick = getNetTime();
+  double endTime = 0;
 
-  // Creating viewport threads
-  for (int i = 0; i < game.playerCount; i++)
+  while (!game->isQuitting)
   {
-    ViewportThreadArgument *args = malloc(sizeof(ViewportThreadArgument));
-    args->viewportIndex = i;
-    args->game = &game;
+    receiveNetInputs(server, game);
+
+    for (int i = 0; i < game->playerCount; i++)
+    {
+      game->playerInputs[i] = consumeNetInput(server, i);
+    }
+
+    beginTraceSpan("tick");
+    stepGame(game);
+    handleGameEvents(game);
+    autosaveGame(game);
+    endTraceSpan();
+
+    // Nobody can pick restart from a menu, so start over after a while
+    if (game->gameOver || game->gameWon)
+    {
+      if (endTime == 0)
+        endTime = getNetTime();
+      else if (getNetTime() - endTime > 10)
+      {
+        restartGame(game);
+        endTime = 0;
+      }
+    }
 
-    pthread_create(&game.viewports[i].thread, NULL, updatePlayer, (void *)args);
+    sendNetSnapshots(server, game);
+
+    nextTick += tickTime;
+    double wait = nextTick - getNetTime();
+    if (wait > 0)
+    {
+      struct timespec sleepTime = {(time_t)wait,
+                                   (long)((wait - (time_t)wait) * 1e9)};
+      nanosleep(&sleepTime, NULL);
+    }
+    else
+    {
+      // Fell behind, don't try to catch up with a burst of ticks
+      nextTick = getNetTime();
+    }
   }
 
-  SetExitKey(KEY_NULL);
+  destroyNetServer(server);
+}
 
-  while (!WindowShouldClose() && !game.isQuitting)
+// Plays on a remote server, the local game only mirrors its snapshots
+void runClient(Game *game, char *address)
+{
+  int port = NET_DEFAULT_PORT;
+  char *separator = strrchr(address, ':');
+  if (separator != NULL)
   {
+    *separator = '\0';
+    port = atoi(separator + 1);
+  }
+
+  NetConnection *connection = connectToServer(address, port);
+  if (connection == NULL)
+    return;
 
-    if (!IsSoundPlaying(game.sound->music) && !game.paused)
+  NetWelcome welcome;
+  int welcomed = 0;
+  double lastHello = -1;
+
+  while (welcomed == 0 && !WindowShouldClose())
+  {
+    if (GetTime() - lastHello > 0.5)
     {
-      PlaySound(game.sound->music);
+      sendNetHello(connection);
+      lastHello = GetTime();
     }
 
-    if (game.frameCount % (game.targetFPS * 5) == 0)
+    welcomed = pollNetWelcome(connection, &welcome);
+
+    BeginDrawing();
+    ClearBackground(BLACK);
+    int fontSize = GetScreenHeight() * 0.05;
+    DrawText("Connecting...",
+             GetScreenWidth() / 2 - MeasureText("Connecting...", fontSize) / 2,
+             GetScreenHeight() / 2 - fontSize / 2, fontSize, WHITE);
+    EndDrawing();
+  }
+
+  if (welcomed != 1)
+  {
+    if (welcomed == -1)
+      printf("ERROR: Server %s:%d is full\n", address, port);
+    closeConnection(connection);
+    return;
+  }
+
+  // The match is sized by the server
+  game->playerCount = welcome.playerCount;
+  game->maxEnemies = welcome.maxEnemies;
+  game->maxSolarCells = welcome.maxSolarCells;
+  game->maxSolarChargers = welcome.maxSolarChargers;
+  game->maxProjectiles = welcome.maxProjectiles;
+  game->mapSize = welcome.mapSize;
+  game->gunRange = welcome.gunRange;
+  game->targetFPS = welcome.targetFPS;
+  game->viewportCount = 1;
+
+  initializeSimulation(game);
+  initializeViewports(game);
+
+  game->viewports[0].player = &game->players[welcome.playerSlot];
+
+  SetTargetFPS(game->targetFPS);
+
+  while (!WindowShouldClose())
+  {
+    // Either keyboard layout drives the remote player
+    PlayerInput input = samplePlayerInput(0);
+    PlayerInput second = samplePlayerInput(1);
+    input.held |= second.held;
+    input.pressed |= second.pressed;
+
+    handleZoomKeys(game);
+
+    Viewport *viewport = &game->viewports[0];
+    sendNetInput(connection, input,
+                 viewport->screenRect.width / 2 / viewport->camera->zoom,
+                 viewport->screenRect.height / 2 / viewport->camera->zoom);
+
+    receiveNetSnapshots(connection, game);
+    updateMessage(game);
+    prepareRenderFrame(game, game->renderPrep);
+    recordHudCommands(game, game->renderPrep);
+
+    BeginDrawing();
+    draw(game);
+
+    if (game->gameOver || game->gameWon)
     {
-      generateSolarCells(&game);
+      DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
+                    Fade(BLACK, 0.7));
+
+      char *titleText = game->gameOver ? "Game Over :(" : "YOU SURVIVED :)";
+      int titleSize = GetScreenHeight() * 0.1;
+      DrawText(titleText,
+               GetScreenWidth() / 2 - MeasureText(titleText, titleSize) / 2,
+               GetScreenHeight() * 0.2, titleSize, WHITE);
     }
 
-    // Pausing
-    if ((IsKeyPressed(KEY_P) || IsKeyPressed(KEY_ESCAPE)) && !game.gameOver &&
-        !game.gameWon)
+    EndDrawing();
+
+    updateResolutionScaling(game, GetFrameTime());
+  }
+
+  closeConnection(connection);
+}
+
+int main(int argc, char **args)
+{
+  Game game = {0};
+  setDefaultGameSettings(&game);
+  game.events = createGameEventQueue();
+  game.randomState = time(NULL);
+  game.tracePath = "trace.json";
+  setTraceThreadName("main");
+
+  initResolutionScaler(&game.resolution, 1.0f / game.targetFPS);
+  initLatencyTracker(&game.latency);
+
+  bool server = false;
+  int serverPort = NET_DEFAULT_PORT;
+  char *serverAddress = NULL;
+  int workerCount = -1;
+  bool lowLatency = false;
+  char *loadPath = NULL;
+  char *savePath = NULL;
+
+  // ./threadwars [--players N] [--min-resolution-scale S] [--fixed-resolution]
+  //              [--server [port]] [--connect host[:port]] [--workers N]
+  //              [--low-latency] [--map-size N] [--load FILE]
+  //              [--autosave FILE] [--trace FILE]
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(args[i], "--players") == 0 && i + 1 < argc)
     {
-      game.paused = !game.paused;
-      if (game.paused)
-      {
-        StopSound(game.sound->music);
-        game.showPauseMenu = game.paused;
-        game.showControlsMenu = false;
-        game.pauseMenuSelection = 0;
-      }
-      else
-      {
+      game.playerCount = atoi(args[++i]);
+    }
+    else if (strcmp(args[i], "--min-resolution-scale") == 0 && i + 1 < argc)
+    {
+      game.resolution.minScale = atof(args[++i]);
+    }
+    else if (strcmp(args[i], "--fixed-resolution") == 0)
+    {
+      game.resolution.enabled = false;
+    }
+    else if (strcmp(args[i], "--server") == 0)
+    {
+      server = true;
+      if (i + 1 < argc && args[i + 1][0] != '-')
+        serverPort = atoi(args[++i]);
+    }
+    else if (strcmp(args[i], "--connect") == 0 && i + 1 < argc)
+    {
+      serverAddress = args[++i];
+    }
+    else if (strcmp(args[i], "--workers") == 0 && i + 1 < argc)
+    {
+      workerCount = atoi(args[++i]);
+    }
+    else if (strcmp(args[i], "--low-latency") == 0)
+    {
+      lowLatency = true;
+    }
+    else if (strcmp(args[i], "--map-size") == 0 && i + 1 < argc)
+    {
+      game.mapSize = atoi(args[++i]);
+    }
+    else if (strcmp(args[i], "--load") == 0 && i + 1 < argc)
+    {
+      loadPath = args[++i];
+    }
+    else if (strcmp(args[i], "--autosave") == 0 && i + 1 < argc)
+    {
+      savePath = args[++i];
+    }
+    else if (strcmp(args[i], "--trace") == 0 && i + 1 < argc)
+    {
+      game.tracePath = args[++i];
+      startTrace();
+    }
+  }
 
-        PlaySound(game.sound->music);
-      }
+  if (game.playerCount < 1)
+    game.playerCount = 1;
+  if (game.playerCount > MAX_PLAYERS)
+    game.playerCount = MAX_PLAYERS;
+  if (game.mapSize < 1000)
+    game.mapSize = 1000;
+  if (game.resolution.minScale < 0.1 ||
+      game.resolution.minScale > game.resolution.maxScale)
+    game.resolution.minScale = 0.5;
+
+  game.pauseMenuSelection = 0;
+  game.showControlsMenu = false;
+  game.showPauseMenu = false;
+
+  // Clients only mirror the server's match, so there is nothing to save
+  if (savePath != NULL && serverAddress == NULL)
+    game.saver = createSaveWriter(savePath);
+
+  if (server)
+  {
+    runServer(&game, serverPort, loadPath);
+    shutdownGame(&game);
+    return 0;
+  }
+
+  // Decoding starts before the window and audio device are up
+  game.assets = createAssetManager(64, 4, "assets/assets.bundle");
+  queueGameAssets(game.assets);
+
+  InitWindow(0, 0, "Thread Wars");
+  InitAudioDevice();
+
+  if (!IsWindowFullscreen())
+  {
+    ToggleFullscreen();
+  }
+
+  if (!showLoadingScreen(&game))
+  {
+    destroyAssetManager(game.assets);
+    shutdownGame(&game);
+    CloseAudioDevice();
+    CloseWindow();
+    return 0;
+  }
+
+  initGameSounds(&game);
+  loadGameTextures(&game);
+
+  // Sounds and textures hold their own copies once uploaded
+  destroyAssetManager(game.assets);
+  game.assets = NULL;
+
+  if (serverAddress != NULL)
+  {
+    runClient(&game, serverAddress);
+    shutdownGame(&game);
+    CloseWindow();
+    CloseAudioDevice();
+    return 0;
+  }
+
+  initializeSimulation(&game);
+  if (loadPath != NULL)
+    loadGame(&game, loadPath);
+
+  // A save brings its own player count
+  game.viewportCount = game.playerCount;
+  initializeViewports(&game);
+
+  setLowLatencyMode(&game, lowLatency);
+
+  game.jobs = createJobSystem(workerCount);
+
+  SetExitKey(KEY_NULL);
+
+  playMusic(game.sound->music);
+
+  // The first frame has no tick simulated ahead of it
+  prepareRenderFrame(&game, game.renderPrep);
+  recordHudCommands(&game, game.renderPrep);
+
+  double presentTime = GetTime();
+  game.latency.pollTime = presentTime;
+
+  while (!WindowShouldClose() && !game.isQuitting)
+  {
+    bool latched = false;
+    if (game.latency.lowLatency)
+      latched = latchInputs(&game, presentTime);
+
+    // The frame count holds still while paused, don't repeat these
+    if (!game.paused && game.frameCount % WORLD_UPDATE_TICKS == 0)
+    {
+      updateWorldChunks(&game);
     }
 
-    // Adding enemies
-    if (IsKeyPressed(KEY_BACKSPACE))
+    if (!game.paused && game.frameCount % (game.targetFPS * 5) == 0)
     {
-      addEnemies(&game, 5);
+      generateSolarCells(&game);
     }
 
+    handleHotkeys(&game);
+
     handleGameOver(&game);
 
-    // Update
-    if (!game.paused)
+    double updateStart = GetTime();
+
+    // Update, the next tick runs on the workers while this one is drawn.
+    // In low latency mode the tick is finished first and drawn right away.
+    bool simulating = !game.paused;
+    bool pipelined = !game.latency.lowLatency;
+    beginTraceSpan("update");
+    if (simulating)
     {
       generateEnemies(&game);
 
       updateMessage(&game);
-      updateEnemies(&game);
 
-      game.frameCount++;
+      if (!latched)
+        sampleInputs(&game);
+      updateEnemyTiers(&game);
+      snapshotEnemyPositions(&game);
+      submitFrameJobs(&game);
+
+      if (!pipelined)
+      {
+        waitForJobs(game.jobs);
+        swapRenderPreps(&game);
+      }
     }
+    else if (!game.pausedFrameValid)
+    {
+      // Freeze the game as it is now, menus may have changed it
+      prepareRenderFrame(&game, game.nextRenderPrep);
+      recordHudCommands(&game, game.nextRenderPrep);
+      swapRenderPreps(&game);
+    }
+
+    endTraceSpan();
+
+    double cpuTime = GetTime() - updateStart;
 
+    beginTraceSpan("draw");
     BeginDrawing();
     // Drawing everything to screen
-    draw(&game);
+    if (simulating)
+      draw(&game);
+    else
+      drawPausedFrame(&game);
 
-    // pause menu
-    if (game.paused && !game.gameOver && !game.gameWon)
+    // pause menu, only once nothing else is touching the game
+    if (!simulating && game.paused && !game.gameOver && !game.gameWon)
     {
       if (game.showControlsMenu)
       {
-        DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
-                      Fade(BLACK, 0.7));
-        int fontSize = GetScreenHeight() * 0.04;
-        int titleSize = GetScreenHeight() * 0.05;
-        int centerX = GetScreenWidth() / 2;
-
-        DrawText("CONTROLS", centerX - MeasureText("CONTROLS", titleSize) / 2,
-                 GetScreenHeight() * 2, titleSize, WHITE);
-
-        // Player1
-        DrawText("PLAYER 1:", centerX - MeasureText("PLAYER 1:", fontSize) / 2,
-                 GetScreenHeight() * 0.3, fontSize, YELLOW);
-        DrawText("WASD - Move",
-                 centerX - MeasureText("WASD - Move", fontSize) / 2,
-                 GetScreenHeight() * 0.35, fontSize, YELLOW);
-        DrawText("SPACE - Shoot",
-                 centerX - MeasureText("SPACE - Shoot", fontSize) / 2,
-                 GetScreenHeight() * 0.4, fontSize, YELLOW);
-        DrawText("1/2 - Build Solar (Small/Large)",
-                 centerX -
-                     MeasureText("1/2 - Build Solar (Small/Large)", fontSize) /
-                         2,
-                 GetScreenHeight() * 0.45, fontSize, YELLOW);
-
-        // Player2
-        DrawText("PLAYER 2:", centerX - MeasureText("PLAYER 2:", fontSize) / 2,
-                 GetScreenHeight() * 0.55, fontSize, YELLOW);
-        DrawText("ARROWS - Move",
-                 centerX - MeasureText("ARROWS - Move", fontSize) / 2,
-                 GetScreenHeight() * 0.60, fontSize, YELLOW);
-        DrawText("ENTER - Shoot",
-                 centerX - MeasureText("ENTER - Shoot", fontSize) / 2,
-                 GetScreenHeight() * 0.65, fontSize, YELLOW);
-        DrawText("9/0 - Build Solar (Small/Large)",
-                 centerX -
-                     MeasureText("9/0 - Build Solar (Small/Large)", fontSize) /
-                         2,
-                 GetScreenHeight() * 0.70, fontSize, YELLOW);
-
-        // Back
-        DrawText("Press BackSpace to go back",
-                 centerX -
-                     MeasureText("Press BackSpace to go back", fontSize) / 2,
-                 GetScreenHeight() * 0.85, fontSize, YELLOW);
+        drawControlsMenu(&game);
         if (IsKeyPressed(KEY_BACKSPACE))
         {
           game.showControlsMenu = false;
@@ -1382,7 +1762,7 @@ int main(int argc, char **args)
       }
     }
 
-    if (game.gameOver || game.gameWon)
+    if (!simulating && (game.gameOver || game.gameWon))
     {
       DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Fade(BLACK, 0.7));
       char titleText[32];
@@ -1406,50 +1786,7 @@ int main(int argc, char **args)
       
       if (game.showControlsMenu)
       {
-        DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
-                      Fade(BLACK, 0.7));
-        int fontSize = GetScreenHeight() * 0.04;
-        int titleSize = GetScreenHeight() * 0.05;
-        int centerX = GetScreenWidth() / 2;
-
-        DrawText("CONTROLS", centerX - MeasureText("CONTROLS", titleSize) / 2,
-                 GetScreenHeight() * 2, titleSize, WHITE);
-
-        // Player1
-        DrawText("PLAYER 1:", centerX - MeasureText("PLAYER 1:", fontSize) / 2,
-                 GetScreenHeight() * 0.3, fontSize, YELLOW);
-        DrawText("WASD - Move",
-                 centerX - MeasureText("WASD - Move", fontSize) / 2,
-                 GetScreenHeight() * 0.35, fontSize, YELLOW);
-        DrawText("SPACE - Shoot",
-                 centerX - MeasureText("SPACE - Shoot", fontSize) / 2,
-                 GetScreenHeight() * 0.4, fontSize, YELLOW);
-        DrawText("1/2 - Build Solar (Small/Large)",
-                 centerX -
-                     MeasureText("1/2 - Build Solar (Small/Large)", fontSize) /
-                         2,
-                 GetScreenHeight() * 0.45, fontSize, YELLOW);
-
-        // Player2
-        DrawText("PLAYER 2:", centerX - MeasureText("PLAYER 2:", fontSize) / 2,
-                 GetScreenHeight() * 0.55, fontSize, YELLOW);
-        DrawText("ARROWS - Move",
-                 centerX - MeasureText("ARROWS - Move", fontSize) / 2,
-                 GetScreenHeight() * 0.60, fontSize, YELLOW);
-        DrawText("ENTER - Shoot",
-                 centerX - MeasureText("ENTER - Shoot", fontSize) / 2,
-                 GetScreenHeight() * 0.65, fontSize, YELLOW);
-        DrawText("9/0 - Build Solar (Small/Large)",
-                 centerX -
-                     MeasureText("9/0 - Build Solar (Small/Large)", fontSize) /
-                         2,
-                 GetScreenHeight() * 0.70, fontSize, YELLOW);
-
-        // Back
-        DrawText("Press BackSpace to go back",
-                 centerX -
-                     MeasureText("Press BackSpace to go back", fontSize) / 2,
-                 GetScreenHeight() * 0.85, fontSize, YELLOW);
+        drawControlsMenu(&game);
         if (IsKeyPressed(KEY_BACKSPACE))
         {
           game.showControlsMenu = false;
@@ -1457,10 +1794,52 @@ int main(int argc, char **args)
       }
     }
 
+    // Menu picks may have resumed the game, which must not wait for input
+    setWaitingForInput(&game, game.paused);
+
     EndDrawing();
+    endTraceSpan();
+
+    // EndDrawing presents the frame, then polls input for the next one
+    presentTime = GetTime();
+    if (latched)
+      recordLatchWorkTime(&game.latency, presentTime - game.latency.pollTime);
+    game.latency.pollTime = presentTime;
+
+    double waitStart = GetTime();
+
+    if (simulating && pipelined)
+      waitForJobs(game.jobs);
+
+    // Only once the jobs are done, the HUD reads the percentiles
+    recordFrameLatency(&game.latency, game.renderPrep->inputTime, presentTime);
+
+    if (simulating)
+    {
+      if (pipelined)
+        swapRenderPreps(&game);
+      updateZombieSounds(&game);
+
+      game.frameCount++;
+
+      // No jobs are running between ticks, so the state holds still
+      autosaveGame(&game);
+    }
+
+    // Player actions report while paused too
+    handleGameEvents(&game);
+
+    // Paused frames mostly wait for input, they say nothing about the load
+    if (simulating)
+    {
+      recordCpuTime(&game.resolution, cpuTime + GetTime() - waitStart);
+
+      // Render textures can only be resized outside of drawing
+      updateResolutionScaling(&game, GetFrameTime());
+    }
   }
 
-  game.isQuitting = true;
+  shutdownGame(&game);
   CloseWindow();
   CloseAudioDevice();
 
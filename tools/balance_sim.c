@@ -0,0 +1,112 @@
+/*
+    Headless balance simulator
+
+    Plays many matches at once through the batched environment API with
+    random inputs, and reports how they went and how fast they ran.
+
+    Build: gcc tools/balance_sim.c -o balance_sim -lraylib -lm -lpthread -ldl
+    Usage: ./balance_sim [instances] [players] [workers] [frames] [trace]
+
+    Given a trace path, the run is recorded and written there as Chrome
+    trace-event JSON.
+*/
+
+#include "../lib/models.h"
+#include "../lib/memory_tracker.h"
+#include "../lib/trace_recorder.h"
+#include "../lib/vector_ops.h"
+#include "../lib/entity_store.h"
+#include "../lib/spatial_grid.h"
+#include "../lib/obstacle_tree.h"
+#include "../lib/minimap.h"
+#include "../lib/world.h"
+#include "../lib/game_events.h"
+#include "../lib/game.h"
+#include "../lib/job_system.h"
+#include "../lib/env.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+double getSimTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char **args)
+{
+  int instanceCount = argc > 1 ? atoi(args[1]) : 1024;
+  int playerCount = argc > 2 ? atoi(args[2]) : 2;
+  int workerCount = argc > 3 ? atoi(args[3]) : -1;
+  int frames = argc > 4 ? atoi(args[4]) : 3600;
+  char *tracePath = argc > 5 ? args[5] : NULL;
+
+  setTraceThreadName("main");
+  if (tracePath != NULL)
+    startTrace();
+
+  GameEnv *env = createGameEnv(instanceCount, playerCount, workerCount, 1);
+  if (env == NULL)
+    return 1;
+
+  PlayerInput *inputs =
+      calloc(instanceCount * playerCount, sizeof(PlayerInput));
+  float *observations =
+      calloc(instanceCount * getGameEnvObservationSize(env), sizeof(float));
+  float *rewards = calloc(instanceCount, sizeof(float));
+  bool *dones = calloc(instanceCount, sizeof(bool));
+
+  resetGameEnv(env, observations);
+
+  unsigned int randomState = 1;
+  int matchesEnded = 0;
+  double totalReward = 0;
+  double start = getSimTime();
+
+  for (int frame = 0; frame < frames; frame++)
+  {
+    // Hold a random direction for half a second at a time, shoot often
+    for (int i = 0; i < instanceCount * playerCount; i++)
+    {
+      if (frame % 30 == 0)
+        inputs[i].held = rand_r(&randomState) & 0x0f;
+      inputs[i].pressed = (rand_r(&randomState) % 10 == 0) ? INPUT_SHOOT : 0;
+    }
+
+    beginTraceSpan("step");
+    stepGameEnv(env, inputs, observations, rewards, dones);
+    endTraceSpan();
+
+    for (int i = 0; i < instanceCount; i++)
+    {
+      totalReward += rewards[i];
+      matchesEnded += dones[i];
+    }
+  }
+
+  double elapsed = getSimTime() - start;
+
+  printf("%d instances x %d frames in %.2fs (%.0f instance frames/s)\n",
+         instanceCount, frames, elapsed, instanceCount * frames / elapsed);
+  printf("%d matches ended, mean reward per instance %.2f\n", matchesEnded,
+         totalReward / instanceCount);
+
+  destroyGameEnv(env);
+
+  if (tracePath != NULL)
+  {
+    stopTrace();
+    writeTrace(tracePath);
+  }
+  destroyTraceRecorder();
+  free(inputs);
+  free(observations);
+  free(rewards);
+  free(dones);
+
+  printMemoryReport();
+
+  return 0;
+}
@@ -0,0 +1,266 @@
+/*
+    False sharing benchmark
+
+    Shows where the fields jobs write land in Game, then times the same
+    writes against the old packed layout and the cache line aligned one in
+    lib/models.c. Any gap between the two is cache lines moving between
+    cores, so it takes at least two cores to show. For hardware counts run
+    it under `perf c2c record` or `perf stat -e cache-misses`.
+
+    Build: gcc tools/false_sharing_bench.c -o false_sharing_bench -lraylib -lm -lpthread -ldl
+    Usage: ./false_sharing_bench [threads] [iterations]
+*/
+
+#include "../lib/models.h"
+#include "../lib/memory_tracker.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Player and the counters around battery as they were packed before
+typedef struct {
+  Vector2 position;
+  int flipDir;
+  float speed;
+  int size;
+  float health;
+  Color color;
+  pthread_mutex_t mutex;
+} PackedPlayer;
+
+typedef struct {
+  int frameCount;
+  unsigned int randomState;
+  int enemiesKilled;
+  float battery;
+  pthread_mutex_t batteryMutex;
+} PackedCounters;
+
+typedef struct {
+  pthread_barrier_t *start;
+  long iterations;
+  double seconds;
+
+  // One of these is set, for a mover or the battery writer
+  Vector2 *position;
+  pthread_mutex_t *mutex;
+  float *battery;
+
+  // Otherwise it reads the frame count
+  volatile int *frameCount;
+  long long sum;
+} BenchThread;
+
+double getBenchTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Moves a player or charges the battery the way the jobs do, or polls the
+// frame count the way every job reads it
+void *runBenchThread(void *arg)
+{
+  BenchThread *thread = (BenchThread *)arg;
+  pthread_barrier_wait(thread->start);
+  double start = getBenchTime();
+
+  for (long i = 0; i < thread->iterations; i++)
+  {
+    if (thread->position != NULL)
+    {
+      pthread_mutex_lock(thread->mutex);
+      thread->position->x += 1;
+      pthread_mutex_unlock(thread->mutex);
+    }
+    else if (thread->battery != NULL)
+    {
+      pthread_mutex_lock(thread->mutex);
+      *thread->battery += 1;
+      pthread_mutex_unlock(thread->mutex);
+    }
+    else
+    {
+      thread->sum += *thread->frameCount;
+    }
+  }
+
+  thread->seconds = getBenchTime() - start;
+  return NULL;
+}
+
+// Runs the threads together and returns their mean nanoseconds per
+// iteration
+double runBench(BenchThread *threads, int threadCount)
+{
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, threadCount);
+  pthread_t *handles = malloc(threadCount * sizeof(pthread_t));
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads[i].start = &start;
+    pthread_create(&handles[i], NULL, runBenchThread, &threads[i]);
+  }
+
+  double total = 0;
+  for (int i = 0; i < threadCount; i++)
+  {
+    pthread_join(handles[i], NULL);
+    total += threads[i].seconds * 1e9 / threads[i].iterations;
+  }
+
+  free(handles);
+  pthread_barrier_destroy(&start);
+
+  return total / threadCount;
+}
+
+// Every thread moves its own player
+double benchPlayers(Vector2 **positions, pthread_mutex_t **mutexes,
+                    int threadCount, long iterations)
+{
+  BenchThread *threads = calloc(threadCount, sizeof(BenchThread));
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads[i].iterations = iterations;
+    threads[i].position = positions[i];
+    threads[i].mutex = mutexes[i];
+  }
+
+  double nanoseconds = runBench(threads, threadCount);
+  free(threads);
+
+  return nanoseconds;
+}
+
+// One thread charges the battery while the rest read the frame count,
+// returns the readers' time
+double benchBattery(float *battery, pthread_mutex_t *mutex, int *frameCount,
+                    int threadCount, long iterations)
+{
+  BenchThread *threads = calloc(threadCount, sizeof(BenchThread));
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads[i].iterations = iterations;
+    threads[i].frameCount = frameCount;
+  }
+  threads[0].battery = battery;
+  threads[0].mutex = mutex;
+
+  runBench(threads, threadCount);
+
+  double total = 0;
+  for (int i = 1; i < threadCount; i++)
+  {
+    total += threads[i].seconds * 1e9 / threads[i].iterations;
+  }
+  free(threads);
+
+  return threadCount > 1 ? total / (threadCount - 1) : 0;
+}
+
+void printFieldLine(const char *name, size_t offset, size_t frameCountOffset)
+{
+  bool shared = offset / CACHE_LINE_SIZE == frameCountOffset / CACHE_LINE_SIZE;
+  printf("  %-22s line %3zu%s\n", name, offset / CACHE_LINE_SIZE,
+         shared && offset != frameCountOffset ? "  shares frameCount's"
+                                              : "");
+}
+
+int main(int argc, char **args)
+{
+  int threadCount = argc > 1 ? atoi(args[1]) : 4;
+  long iterations = argc > 2 ? atol(args[2]) : 10000000;
+  if (threadCount < 2)
+    threadCount = 2;
+  if (threadCount > MAX_PLAYERS)
+    threadCount = MAX_PLAYERS;
+
+  size_t frameCount = offsetof(Game, frameCount);
+  printf("Game is %zu bytes, fields jobs write:\n", sizeof(Game));
+  printFieldLine("frameCount", frameCount, frameCount);
+  printFieldLine("battery", offsetof(Game, battery), frameCount);
+  printFieldLine("batteryMutex", offsetof(Game, batteryMutex), frameCount);
+  printFieldLine("enemyCount", offsetof(Game, enemyCount), frameCount);
+  printFieldLine("enemiesKilled", offsetof(Game, enemiesKilled), frameCount);
+  printFieldLine("solarCellsCollected", offsetof(Game, solarCellsCollected),
+                 frameCount);
+  printFieldLine("enemies.liveCount",
+                 offsetof(Game, enemies) + offsetof(EntityArchetype, liveCount),
+                 frameCount);
+  printFieldLine("projectiles.liveCount",
+                 offsetof(Game, projectiles) +
+                     offsetof(EntityArchetype, liveCount),
+                 frameCount);
+  printf("Player is %zu bytes (packed %zu)\n\n", sizeof(Player),
+         sizeof(PackedPlayer));
+
+  // Before: players side by side, battery next to the frame count
+  PackedPlayer *packedPlayers = calloc(threadCount, sizeof(PackedPlayer));
+  PackedCounters *packedCounters = calloc(1, sizeof(PackedCounters));
+
+  // After: as the game allocates them
+  Player *players =
+      trackedAlignedCalloc(MEMORY_ENTITIES, threadCount, sizeof(Player));
+  Game *game = trackedAlignedCalloc(MEMORY_ENTITIES, 1, sizeof(Game));
+
+  Vector2 *positions[MAX_PLAYERS];
+  pthread_mutex_t *mutexes[MAX_PLAYERS];
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    pthread_mutex_init(&packedPlayers[i].mutex, NULL);
+    positions[i] = &packedPlayers[i].position;
+    mutexes[i] = &packedPlayers[i].mutex;
+  }
+  double packedMove = benchPlayers(positions, mutexes, threadCount, iterations);
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    pthread_mutex_init(&players[i].mutex, NULL);
+    positions[i] = &players[i].position;
+    mutexes[i] = &players[i].mutex;
+  }
+  double alignedMove =
+      benchPlayers(positions, mutexes, threadCount, iterations);
+
+  pthread_mutex_init(&packedCounters->batteryMutex, NULL);
+  double packedPoll = benchBattery(
+      &packedCounters->battery, &packedCounters->batteryMutex,
+      &packedCounters->frameCount, threadCount, iterations);
+
+  pthread_mutex_init(&game->batteryMutex, NULL);
+  double alignedPoll =
+      benchBattery(&game->battery, &game->batteryMutex, &game->frameCount,
+                   threadCount, iterations);
+
+  printf("%d threads x %ld iterations\n", threadCount, iterations);
+  printf("  move own player:     packed %6.2f ns, aligned %6.2f ns\n",
+         packedMove, alignedMove);
+  printf("  poll frame count:    packed %6.2f ns, aligned %6.2f ns\n",
+         packedPoll, alignedPoll);
+  printf("  (while one thread charges the battery)\n");
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    pthread_mutex_destroy(&packedPlayers[i].mutex);
+    pthread_mutex_destroy(&players[i].mutex);
+  }
+  pthread_mutex_destroy(&packedCounters->batteryMutex);
+  pthread_mutex_destroy(&game->batteryMutex);
+
+  free(packedPlayers);
+  free(packedCounters);
+  trackedFree(players);
+  trackedFree(game);
+
+  printMemoryReport();
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+/*
+    Offline asset packer
+
+    Decodes every sound and image under an asset directory and writes them
+    into a single bundle of raw PCM and RGBA payloads with a small index, so
+    the game can mmap it at startup instead of opening and decoding each file.
+
+    Build: gcc tools/pack_assets.c -o pack_assets -lraylib -lm -lpthread -ldl
+    Usage: ./pack_assets [assets] [assets/assets.bundle]
+*/
+
+#include "../lib/models.h"
+#include "../lib/memory_tracker.h"
+#include "../lib/asset_bundle.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PACKED_ASSETS 512
+
+typedef struct
+{
+  AssetBundleEntry entry;
+  void *data;
+  bool duplicate;
+} PackedAsset;
+
+PackedAsset packedAssets[MAX_PACKED_ASSETS];
+int packedAssetCount = 0;
+
+bool hasExtension(const char *path, const char *extensions[], int count)
+{
+  const char *extension = strrchr(path, '.');
+  if (extension == NULL)
+    return false;
+
+  for (int i = 0; i < count; i++)
+  {
+    if (strcmp(extension, extensions[i]) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+void packFile(const char *path)
+{
+  const char *waveExtensions[] = {".wav", ".ogg", ".qoa", ".mp3", ".flac"};
+  const char *imageExtensions[] = {".png", ".bmp", ".jpg", ".jpeg"};
+
+  if (packedAssetCount == MAX_PACKED_ASSETS)
+  {
+    printf("ERROR: Too many assets, skipping %s\n", path);
+    return;
+  }
+
+  if (strlen(path) >= ASSET_NAME_LENGTH)
+  {
+    printf("ERROR: Asset path too long, skipping %s\n", path);
+    return;
+  }
+
+  // Background music is streamed from its own file at runtime
+  const char *filename = strrchr(path, '/');
+  if (strncmp(filename ? filename + 1 : path, "music.", 6) == 0)
+    return;
+
+  PackedAsset *asset = &packedAssets[packedAssetCount];
+  memset(asset, 0, sizeof(PackedAsset));
+  strcpy(asset->entry.name, path);
+
+  if (hasExtension(path, waveExtensions, 5))
+  {
+    Wave wave = LoadWave(path);
+    if (wave.data == NULL)
+    {
+      printf("ERROR: Failed to decode %s\n", path);
+      return;
+    }
+
+    asset->entry.type = ASSET_TYPE_WAVE;
+    asset->entry.size =
+        (uint64_t)wave.frameCount * wave.channels * (wave.sampleSize / 8);
+    asset->entry.params[0] = wave.frameCount;
+    asset->entry.params[1] = wave.sampleRate;
+    asset->entry.params[2] = wave.sampleSize;
+    asset->entry.params[3] = wave.channels;
+    asset->data = wave.data;
+  }
+  else if (hasExtension(path, imageExtensions, 4))
+  {
+    Image image = LoadImage(path);
+    if (image.data == NULL)
+    {
+      printf("ERROR: Failed to decode %s\n", path);
+      return;
+    }
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    asset->entry.type = ASSET_TYPE_IMAGE;
+    asset->entry.size = (uint64_t)image.width * image.height * 4;
+    asset->entry.params[0] = image.width;
+    asset->entry.params[1] = image.height;
+    asset->entry.params[2] = image.format;
+    asset->entry.params[3] = 1;
+    asset->data = image.data;
+  }
+  else
+  {
+    return;
+  }
+
+  asset->entry.hash = hashAssetData(asset->data, asset->entry.size);
+
+  printf("Packed %s (%llu bytes)\n", path,
+         (unsigned long long)asset->entry.size);
+  packedAssetCount++;
+}
+
+void packDirectory(const char *directory)
+{
+  DIR *dir = opendir(directory);
+  if (dir == NULL)
+  {
+    printf("ERROR: Cannot open %s\n", directory);
+    return;
+  }
+
+  struct dirent *item;
+  while ((item = readdir(dir)) != NULL)
+  {
+    if (item->d_name[0] == '.')
+      continue;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, item->d_name);
+
+    if (item->d_type == DT_DIR)
+      packDirectory(path);
+    else
+      packFile(path);
+  }
+
+  closedir(dir);
+}
+
+uint64_t alignOffset(uint64_t offset)
+{
+  return (offset + ASSET_BUNDLE_ALIGNMENT - 1) &
+         ~(uint64_t)(ASSET_BUNDLE_ALIGNMENT - 1);
+}
+
+int main(int argc, char **args)
+{
+  const char *assetDirectory = argc > 1 ? args[1] : "assets";
+  const char *outputPath = argc > 2 ? args[2] : "assets/assets.bundle";
+
+  SetTraceLogLevel(LOG_WARNING);
+  packDirectory(assetDirectory);
+
+  // Lay out payloads after the index, reusing pages for identical data
+  uint64_t offset = alignOffset(sizeof(AssetBundleHeader) +
+                                packedAssetCount * sizeof(AssetBundleEntry));
+
+  for (int i = 0; i < packedAssetCount; i++)
+  {
+    PackedAsset *asset = &packedAssets[i];
+
+    for (int j = 0; j < i; j++)
+    {
+      if (!packedAssets[j].duplicate &&
+          packedAssets[j].entry.hash == asset->entry.hash &&
+          packedAssets[j].entry.size == asset->entry.size &&
+          memcmp(packedAssets[j].data, asset->data, asset->entry.size) == 0)
+      {
+        asset->duplicate = true;
+        asset->entry.offset = packedAssets[j].entry.offset;
+        break;
+      }
+    }
+
+    if (!asset->duplicate)
+    {
+      asset->entry.offset = offset;
+      offset = alignOffset(offset + asset->entry.size);
+    }
+  }
+
+  FILE *file = fopen(outputPath, "wb");
+  if (file == NULL)
+  {
+    printf("ERROR: Cannot write %s\n", outputPath);
+    return 1;
+  }
+
+  AssetBundleHeader header = {ASSET_BUNDLE_MAGIC, ASSET_BUNDLE_VERSION,
+                              packedAssetCount, 0};
+  fwrite(&header, sizeof(header), 1, file);
+
+  for (int i = 0; i < packedAssetCount; i++)
+  {
+    fwrite(&packedAssets[i].entry, sizeof(AssetBundleEntry), 1, file);
+  }
+
+  for (int i = 0; i < packedAssetCount; i++)
+  {
+    if (packedAssets[i].duplicate)
+      continue;
+
+    fseek(file, packedAssets[i].entry.offset, SEEK_SET);
+    fwrite(packedAssets[i].data, 1, packedAssets[i].entry.size, file);
+  }
+
+  // Pad the final payload to a full page
+  fseek(file, offset - 1, SEEK_SET);
+  fputc(0, file);
+  fclose(file);
+
+  for (int i = 0; i < packedAssetCount; i++)
+  {
+    MemFree(packedAssets[i].data);
+  }
+
+  printf("Wrote %d assets to %s (%llu bytes)\n", packedAssetCount, outputPath,
+         (unsigned long long)offset);
+
+  return 0;
+}